@@ -1,6 +1,8 @@
 #include <mephisto/buffer>
 #include <mephisto/algorithm/copy>
+#include <mephisto/algorithm/for_each>
 #include <libdash.h>
+#include "check.h"
 #include <alpaka/alpaka.hpp>
 
 
@@ -57,5 +59,16 @@ int main(int argc, char *argv[]) {
     // Copy buf from the host to the device
     mephisto::copy(queue, buf, deviceBuf);
 
+    // Run a kernel on every element of the global range. Each unit works on
+    // its local portion only.
+    mephisto::for_each<Acc>(ctx, queue, arr.begin(), arr.end(),
+      [](Data &value) { value *= 2; });
+
+    for (auto it = arr.lbegin(); it != arr.lend(); ++it) {
+      CHECK(*it == 10.0);
+    }
+
+    dash::finalize();
+
     return 0;
 }
@@ -0,0 +1,94 @@
+#include <mephisto/buffer>
+#include <mephisto/algorithm/for_each>
+#include <libdash.h>
+#include <alpaka/alpaka.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+/**
+ * Element-wise update that is expensive enough to not be bound by memory
+ * bandwidth alone.
+ */
+struct Update {
+    template<
+        typename TData>
+    ALPAKA_FN_HOST_ACC void operator()(TData &value) const {
+        value = std::sqrt(value * value + 1.0) * 0.5;
+    }
+};
+
+int main(int argc, char *argv[]) {
+    using Data = double;
+    using ArrT = dash::Array<Data>;
+    using Dim = alpaka::dim::DimInt<1>;
+
+    dash::init(&argc, &argv);
+
+    std::size_t nelem = 1 << 24;
+    if (argc > 1) {
+        std::istringstream in(argv[1]);
+        in >> nelem;
+    }
+    int repetitions = 10;
+    if (argc > 2) {
+        std::istringstream in(argv[2]);
+        in >> repetitions;
+    }
+
+    ArrT arr(nelem);
+    using Size = decltype(arr.size());
+
+    using Acc       = alpaka::acc::AccCpuOmp2Blocks<Dim, Size>;
+    using Host      = alpaka::acc::AccCpuSerial<Dim, Size>;
+    using QueueAcc  = alpaka::queue::QueueCpuSync;
+
+    using DevAcc    = alpaka::dev::Dev<Acc>;
+    using DevHost   = alpaka::dev::Dev<Host>;
+    using PltfHost  = alpaka::pltf::Pltf<DevHost>;
+    using PltfAcc   = alpaka::pltf::Pltf<DevAcc>;
+
+    DevAcc const devAcc(alpaka::pltf::getDevByIdx<PltfAcc>(0u));
+    DevHost const devHost(alpaka::pltf::getDevByIdx<PltfHost>(0u));
+    QueueAcc queue(devAcc);
+
+    auto ctx = mephisto::make_ctx(devHost, devAcc);
+
+    Update update;
+
+    // Serial baseline: every unit runs std::for_each on its local portion
+    dash::fill(arr.begin(), arr.end(), 1.0);
+    auto const tpSerialStart(std::chrono::high_resolution_clock::now());
+    for (int r = 0; r < repetitions; ++r) {
+        dash::for_each(arr.begin(), arr.end(), update);
+    }
+    auto const tpSerialEnd(std::chrono::high_resolution_clock::now());
+
+    // Parallel: every unit runs a kernel on its local portion
+    dash::fill(arr.begin(), arr.end(), 1.0);
+    auto const tpAccStart(std::chrono::high_resolution_clock::now());
+    for (int r = 0; r < repetitions; ++r) {
+        mephisto::for_each<Acc>(ctx, queue, arr.begin(), arr.end(), update);
+    }
+    auto const tpAccEnd(std::chrono::high_resolution_clock::now());
+
+    auto const serialUs = std::chrono::duration_cast<std::chrono::microseconds>(tpSerialEnd - tpSerialStart).count();
+    auto const accUs    = std::chrono::duration_cast<std::chrono::microseconds>(tpAccEnd - tpAccStart).count();
+
+    if (dash::myid() == 0) {
+        std::cout << "units elements repetitions dash_us mephisto_us speedup" << std::endl;
+        std::cout << dash::size() << " "
+                  << nelem << " "
+                  << repetitions << " "
+                  << serialUs << " "
+                  << accUs << " "
+                  << static_cast<double>(serialUs) / static_cast<double>(accUs)
+                  << std::endl;
+    }
+
+    dash::finalize();
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <mephisto/buffer>
+#include <mephisto/algorithm/reduce>
+#include <libdash.h>
+#include <alpaka/alpaka.hpp>
+
+#include "check.h"
+#include <cmath>
+
+struct Square {
+    template<
+        typename TData>
+    ALPAKA_FN_HOST_ACC TData operator()(TData const &value) const {
+        return value * value;
+    }
+};
+
+struct Plus {
+    template<
+        typename TData>
+    ALPAKA_FN_HOST_ACC TData operator()(TData const &lhs, TData const &rhs) const {
+        return lhs + rhs;
+    }
+};
+
+struct Max {
+    template<
+        typename TData>
+    ALPAKA_FN_HOST_ACC TData operator()(TData const &lhs, TData const &rhs) const {
+        return lhs < rhs ? rhs : lhs;
+    }
+};
+
+int main(int argc, char *argv[]) {
+    using Data = double;
+    using ArrT = dash::Array<Data>;
+    using Dim = alpaka::dim::DimInt<1>;
+
+    dash::init(&argc, &argv);
+
+    // Fill the array with 1, 2, ..., n
+    ArrT arr(1000);
+    auto lbegin_gidx = arr.pattern().global(0);
+    for (decltype(arr.lsize()) i = 0; i < arr.lsize(); ++i) {
+        arr.lbegin()[i] = static_cast<Data>(lbegin_gidx + i + 1);
+    }
+    arr.barrier();
+
+    using Size = decltype(arr.size());
+
+    using Acc       = alpaka::acc::AccCpuSerial<Dim, Size>;
+    using Host      = alpaka::acc::AccCpuSerial<Dim, Size>;
+    using QueueAcc  = alpaka::queue::QueueCpuSync;
+
+    using DevAcc    = alpaka::dev::Dev<Acc>;
+    using DevHost   = alpaka::dev::Dev<Host>;
+    using PltfHost  = alpaka::pltf::Pltf<DevHost>;
+    using PltfAcc   = alpaka::pltf::Pltf<DevAcc>;
+
+    DevAcc const devAcc(alpaka::pltf::getDevByIdx<PltfAcc>(0u));
+    DevHost const devHost(alpaka::pltf::getDevByIdx<PltfHost>(0u));
+    QueueAcc queue(devAcc);
+
+    auto ctx = mephisto::make_ctx(devHost, devAcc);
+
+    Data const n = static_cast<Data>(arr.size());
+
+    auto sum = mephisto::reduce<Acc>(ctx, queue, arr.begin(), arr.end(), 0.0);
+    CHECK(sum == n * (n + 1) / 2);
+
+    auto max = mephisto::reduce<Acc>(ctx, queue, arr.begin(), arr.end(), 0.0, Max());
+    CHECK(max == n);
+
+    // The squared euclidean norm of the vector
+    auto norm2 = mephisto::transform_reduce<Acc>(
+        ctx, queue, arr.begin(), arr.end(), 0.0, Plus(), Square());
+    CHECK(norm2 == n * (n + 1) * (2 * n + 1) / 6);
+
+    dash::finalize();
+
+    return 0;
+}
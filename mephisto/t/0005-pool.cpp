@@ -0,0 +1,85 @@
+#include <mephisto/pool>
+#include <alpaka/alpaka.hpp>
+
+#include "check.h"
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+int
+main()
+{
+    using Dim = alpaka::dim::DimInt<1>;
+    using Acc = alpaka::acc::AccCpuSerial<Dim, std::size_t>;
+    using DevAcc = alpaka::dev::Dev<Acc>;
+    using PltfAcc = alpaka::pltf::Pltf<DevAcc>;
+
+    DevAcc const devAcc(alpaka::pltf::getDevByIdx<PltfAcc>(0u));
+
+    auto &pool = mephisto::get_pool(devAcc);
+    CHECK(&pool == &mephisto::get_pool(devAcc));
+
+    {
+        auto a = pool.alloc<double>(100);
+        auto b = pool.alloc<float>(1000);
+        CHECK(a.size() == 100);
+        CHECK(b.size() == 1000);
+        CHECK(a.data() != nullptr);
+        CHECK(static_cast<void *>(a.data()) != static_cast<void *>(b.data()));
+        CHECK(pool.statistics().allocations == 2);
+        CHECK(pool.statistics().bytes_in_use >= 100 * sizeof(double) + 1000 * sizeof(float));
+    }
+    // Both buffers went out of scope and were released to the pool
+    CHECK(pool.statistics().bytes_in_use == 0);
+    CHECK(pool.statistics().arenas == 1);
+
+    {
+        // Same size class as before, no new memory is needed
+        auto a = pool.alloc<double>(120);
+        auto moved = std::move(a);
+        CHECK(pool.statistics().reuses == 1);
+        CHECK(pool.statistics().arenas == 1);
+    }
+    CHECK(pool.statistics().bytes_in_use == 0);
+
+    pool.trim();
+    CHECK(pool.statistics().arenas == 0);
+
+    // Host arenas follow the allocation policy, blocks stay aligned to
+    // their smallest size class
+    mephisto::default_allocation_policy() = mephisto::parse_allocation_policy("thp");
+    {
+        auto a = pool.alloc<double>(100);
+        auto b = pool.alloc<double>(100);
+        a.data()[99] = 1.0;
+        CHECK(reinterpret_cast<std::uintptr_t>(a.data()) % mephisto::MemoryPool<DevAcc>::MinClassBytes == 0);
+        CHECK(reinterpret_cast<std::uintptr_t>(b.data()) % mephisto::MemoryPool<DevAcc>::MinClassBytes == 0);
+    }
+    pool.trim();
+
+    // No buffer is in use, so the pool itself can be released
+    CHECK(mephisto::release_pools<DevAcc>());
+
+    // Misspelled policies are rejected instead of selecting the default
+    CHECK(mephisto::parse_allocation_policy("huge:4096").alignment == 4096);
+    for (auto spec : {"hgue:100", "thp:100", "default:", "default:64k"}) {
+        bool thrown = false;
+        try {
+            mephisto::parse_allocation_policy(spec);
+        } catch (std::runtime_error &) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+
+    // Workspace vectors keep their memory across requests
+    auto &w = mephisto::workspace<double>(0, 1000, 1.0);
+    double *data = w.data();
+    CHECK(w.size() == 1000 && w[999] == 1.0);
+    CHECK(&mephisto::workspace<double>(3, 10) != &w);
+    auto &v = mephisto::workspace<double>(0, 500, 2.0);
+    CHECK(&v == &w && v.data() == data && v.size() == 500 && v[499] == 2.0);
+
+    return 0;
+}
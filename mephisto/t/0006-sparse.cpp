@@ -0,0 +1,139 @@
+#include <mephisto/sparse>
+#include <libdash.h>
+
+#include "check.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using Size = std::size_t;
+
+// Dense row-major product y = A * x
+std::vector<double> dense_product(const std::vector<double> &A, const std::vector<double> &x,
+                                  Size rows, Size cols) {
+  std::vector<double> y(rows, 0.0);
+  for (Size r = 0; r < rows; ++r) {
+    for (Size c = 0; c < cols; ++c) {
+      y[r] += A[r * cols + c] * x[c];
+    }
+  }
+  return y;
+}
+
+void check_tiles(Size rows, Size cols, Size C, Size sigma) {
+  // Rows with 0 to 4 nonzeros in a varying pattern
+  std::vector<double> A(rows * cols, 0.0);
+  for (Size r = 0; r < rows; ++r) {
+    for (Size j = 0; j < (r * 7) % 5; ++j) {
+      A[r * cols + (r + 3 * j) % cols] = static_cast<double>(r + j + 1);
+    }
+  }
+  std::vector<double> x(cols);
+  for (Size c = 0; c < cols; ++c) {
+    x[c] = static_cast<double>(c % 7) - 3.0;
+  }
+  auto y_ref = dense_product(A, x, rows, cols);
+
+  mephisto::TileInfo<Size> info{0, rows, cols, 0, 0};
+  auto csr = mephisto::compress_tile(A.data(), info);
+  CHECK(csr.row_ptr.size() == rows + 1);
+  CHECK(csr.nnz() == static_cast<Size>(std::count_if(A.begin(), A.end(),
+                                                     [](double v) { return v != 0.0; })));
+
+  std::vector<double> y(rows, 1.0);
+  mephisto::spmv(y.data(), csr, x.data());
+  for (Size r = 0; r < rows; ++r) {
+    CHECK(y[r] == y_ref[r] + 1.0);
+  }
+
+  auto sell = mephisto::to_sell(csr, C, sigma);
+  Size const num_chunks = (rows + C - 1) / C;
+  CHECK(sell.num_chunks() == num_chunks);
+  CHECK(sell.chunk_ptr.size() == num_chunks + 1);
+  CHECK(sell.slot_row.size() == num_chunks * C);
+  CHECK(sell.values.size() == sell.chunk_ptr.back());
+
+  // Every row appears once, sorted by decreasing length within a window
+  std::vector<Size> seen(rows, 0);
+  auto row_len = [&](Size r) { return csr.row_ptr[r + 1] - csr.row_ptr[r]; };
+  for (Size slot = 0; slot < sell.slot_row.size(); ++slot) {
+    Size const r = sell.slot_row[slot];
+    if (slot >= rows) {
+      CHECK(r == rows);
+      continue;
+    }
+    CHECK(r < rows);
+    CHECK(slot / std::max<Size>(sigma, 1) == r / std::max<Size>(sigma, 1));
+    ++seen[r];
+    if (slot % std::max<Size>(sigma, 1) > 0) {
+      CHECK(row_len(sell.slot_row[slot - 1]) >= row_len(r));
+    }
+  }
+  CHECK(std::all_of(seen.begin(), seen.end(), [](Size n) { return n == 1; }));
+
+  // Every chunk is as wide as its longest row
+  for (Size chunk = 0; chunk < num_chunks; ++chunk) {
+    Size width = 0;
+    for (Size lane = 0; lane < C; ++lane) {
+      Size const r = sell.slot_row[chunk * C + lane];
+      if (r < rows) {
+        width = std::max(width, row_len(r));
+      }
+    }
+    CHECK(sell.chunk_len[chunk] == width);
+    CHECK(sell.chunk_ptr[chunk + 1] - sell.chunk_ptr[chunk] == width * C);
+  }
+
+  std::fill(y.begin(), y.end(), 1.0);
+  mephisto::spmv(y.data(), sell, x.data());
+  for (Size r = 0; r < rows; ++r) {
+    CHECK(y[r] == y_ref[r] + 1.0);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  dash::init(&argc, &argv);
+
+  check_tiles(37, 23, 4, 1);
+  check_tiles(37, 23, 4, 16);
+  check_tiles(8, 8, 8, 8);
+  check_tiles(5, 11, 8, 3);
+
+  // A matrix built from the nonzeros of its rows equals the compressed
+  // dense matrix
+  Size const n = 64;
+  dash::TilePattern<2> pattern(dash::SizeSpec<2>(n, n),
+                               dash::DistributionSpec<2>(dash::TILE(16), dash::TILE(16)),
+                               dash::TeamSpec<2>(),
+                               dash::Team::All());
+  dash::Matrix<double, 2> dense(pattern);
+  for (auto &tile : mephisto::pattern_local_tiles<Size>(pattern)) {
+    for (Size r = 0; r < tile.rows; ++r) {
+      for (Size c = 0; c < tile.cols; ++c) {
+        Size const row = tile.row + r;
+        Size const col = tile.col + c;
+        dense.lbegin()[tile.offset + r * tile.cols + c] =
+          row == col ? 2.0 : (row + 1 == col || col + 1 == row ? -1.0 : 0.0);
+      }
+    }
+  }
+  dense.barrier();
+
+  mephisto::SparseTileMatrix<double> compressed(dense);
+  mephisto::SparseTileMatrix<double> generated(pattern, [](Size r, Size begin, Size end, auto emit) {
+    for (Size c = std::max(begin, r > 0 ? r - 1 : 0); c < std::min(end, r + 2); ++c) {
+      emit(c, r == c ? 2.0 : -1.0);
+    }
+  });
+  CHECK(compressed.tiles().size() == generated.tiles().size());
+  CHECK(compressed.local_nnz() == generated.local_nnz());
+  for (Size t = 0; t < generated.tiles().size(); ++t) {
+    CHECK(compressed.tile(t).row_ptr == generated.tile(t).row_ptr);
+    CHECK(compressed.tile(t).col_idx == generated.tile(t).col_idx);
+    CHECK(compressed.tile(t).values == generated.tile(t).values);
+  }
+
+  dash::finalize();
+
+  return 0;
+}
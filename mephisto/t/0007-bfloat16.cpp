@@ -0,0 +1,59 @@
+#include <mephisto/bfloat16>
+
+#include "check.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+
+using mephisto::bfloat16;
+
+float from_bits(std::uint32_t u) {
+  float value;
+  std::memcpy(&value, &u, sizeof(value));
+  return value;
+}
+
+int main() {
+  static_assert(sizeof(bfloat16) == 2, "bfloat16 has to be 16 bits wide");
+
+  // Values with at most 8 significant bits are exact
+  for (float value : {0.0f, -0.0f, 1.0f, -2.5f, 0.15625f, 255.0f,
+                      std::ldexp(1.5f, 100), -std::ldexp(1.25f, -100)}) {
+    CHECK(static_cast<float>(bfloat16(value)) == value);
+  }
+  CHECK(std::signbit(static_cast<float>(bfloat16(-0.0f))));
+
+  // The spacing of bfloat16 numbers in [1, 2) is 2^-7
+  float const ulp = 1.0f / 128;
+  CHECK(static_cast<float>(bfloat16(1.0f + ulp)) == 1.0f + ulp);
+  // Below and above the midpoint round to the nearest neighbour
+  CHECK(static_cast<float>(bfloat16(1.0f + 0.49f * ulp)) == 1.0f);
+  CHECK(static_cast<float>(bfloat16(1.0f + 0.51f * ulp)) == 1.0f + ulp);
+  // Ties round to the neighbour with an even last bit
+  CHECK(static_cast<float>(bfloat16(1.0f + 0.5f * ulp)) == 1.0f);
+  CHECK(static_cast<float>(bfloat16(1.0f + 1.5f * ulp)) == 1.0f + 2 * ulp);
+  CHECK(static_cast<float>(bfloat16(-1.0f - 1.5f * ulp)) == -1.0f - 2 * ulp);
+
+  // The relative rounding error is at most 2^-8
+  for (int i = 1; i < 10000; ++i) {
+    float const value = 1.0f / static_cast<float>(i) + static_cast<float>(i);
+    float const rounded = bfloat16(value);
+    CHECK(std::abs(rounded - value) <= std::abs(value) / 256);
+  }
+
+  // Overflow rounds to infinity, infinities and NaNs are kept
+  float const inf = std::numeric_limits<float>::infinity();
+  CHECK(static_cast<float>(bfloat16(std::numeric_limits<float>::max())) == inf);
+  CHECK(static_cast<float>(bfloat16(-inf)) == -inf);
+  CHECK(std::isnan(static_cast<float>(bfloat16(std::numeric_limits<float>::quiet_NaN()))));
+  // A NaN with payload only in the lower half stays a NaN
+  CHECK(std::isnan(static_cast<float>(bfloat16(from_bits(0x7f800001u)))));
+
+  // Denormals keep their upper bits
+  float const denormal = from_bits(0x00010000u);
+  CHECK(static_cast<float>(bfloat16(denormal)) == denormal);
+
+  return 0;
+}
@@ -0,0 +1,191 @@
+#include <mephisto/io>
+#include <libdash.h>
+
+#include "check.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using Entries = std::map<std::pair<std::uint64_t, std::uint64_t>, double>;
+
+// Write a Matrix Market file and collect the elements the parser reports
+Entries parse(const std::string &path, const std::string &contents,
+              mephisto::MatrixMarketInfo &info) {
+  std::ofstream(path) << contents;
+  Entries entries;
+  info = mephisto::parse_matrix_market<double>(
+    path, [&](std::uint64_t row, std::uint64_t col, double value) {
+      CHECK(entries.count({row, col}) == 0);
+      entries[{row, col}] = value;
+    });
+  std::remove(path.c_str());
+  return entries;
+}
+
+void check_matrix_market(const std::string &path) {
+  mephisto::MatrixMarketInfo info;
+
+  auto general = parse(path,
+    "%%MatrixMarket matrix coordinate real general\n"
+    "% a comment\n"
+    "3 4 3\n"
+    "1 1 1.5\n"
+    "3 4 -2\n"
+    "2 3 1e2\n", info);
+  CHECK(info.rows == 3 && info.cols == 4 && info.entries == 3);
+  CHECK(info.coordinate && !info.pattern && !info.symmetric);
+  CHECK((general == Entries{{{0, 0}, 1.5}, {{2, 3}, -2.0}, {{1, 2}, 100.0}}));
+
+  auto symmetric = parse(path,
+    "%%MatrixMarket matrix coordinate integer symmetric\n"
+    "3 3 2\n"
+    "1 1 4\n"
+    "3 1 5\n", info);
+  CHECK(info.symmetric && !info.skew);
+  CHECK((symmetric == Entries{{{0, 0}, 4.0}, {{2, 0}, 5.0}, {{0, 2}, 5.0}}));
+
+  auto skew = parse(path,
+    "%%MatrixMarket matrix coordinate real skew-symmetric\n"
+    "2 2 1\n"
+    "2 1 3\n", info);
+  CHECK(info.skew);
+  CHECK((skew == Entries{{{1, 0}, 3.0}, {{0, 1}, -3.0}}));
+
+  auto pattern = parse(path,
+    "%%MatrixMarket matrix coordinate pattern general\n"
+    "2 2 2\n"
+    "1 2\n"
+    "2 1\n", info);
+  CHECK(info.pattern);
+  CHECK((pattern == Entries{{{0, 1}, 1.0}, {{1, 0}, 1.0}}));
+
+  // Array format is column-major
+  auto array = parse(path,
+    "%%MatrixMarket matrix array real general\n"
+    "2 3\n"
+    "1\n2\n3\n4\n5\n6\n", info);
+  CHECK(!info.coordinate && info.entries == 6);
+  CHECK((array == Entries{{{0, 0}, 1.0}, {{1, 0}, 2.0}, {{0, 1}, 3.0},
+                          {{1, 1}, 4.0}, {{0, 2}, 5.0}, {{1, 2}, 6.0}}));
+
+  // Symmetric arrays only hold the lower triangle, skew ones without the
+  // diagonal
+  auto symmetric_array = parse(path,
+    "%%MatrixMarket matrix array real symmetric\n"
+    "3 3\n"
+    "1\n2\n3\n4\n5\n6\n", info);
+  CHECK(info.entries == 6);
+  CHECK((symmetric_array == Entries{{{0, 0}, 1.0}, {{1, 0}, 2.0}, {{2, 0}, 3.0},
+                                    {{0, 1}, 2.0}, {{0, 2}, 3.0}, {{1, 1}, 4.0},
+                                    {{2, 1}, 5.0}, {{1, 2}, 5.0}, {{2, 2}, 6.0}}));
+
+  auto skew_array = parse(path,
+    "%%MatrixMarket matrix array real skew-symmetric\n"
+    "3 3\n"
+    "1\n2\n3\n", info);
+  CHECK(info.entries == 3);
+  CHECK((skew_array == Entries{{{1, 0}, 1.0}, {{2, 0}, 2.0}, {{2, 1}, 3.0},
+                               {{0, 1}, -1.0}, {{0, 2}, -2.0}, {{1, 2}, -3.0}}));
+
+  // Unsupported and truncated files are rejected
+  bool thrown = false;
+  try {
+    parse(path, "%%MatrixMarket matrix coordinate complex general\n1 1 1\n1 1 1 0\n", info);
+  } catch (std::runtime_error &) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  thrown = false;
+  try {
+    parse(path, "%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1\n", info);
+  } catch (std::runtime_error &) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  std::remove(path.c_str());
+}
+
+int main(int argc, char *argv[]) {
+  dash::init(&argc, &argv);
+
+  check_matrix_market("0008-io-" + std::to_string(dash::myid()) + ".mtx");
+
+  // Round trip through the tiled format with tiles that do not divide the
+  // extents
+  std::size_t const rows = 45;
+  std::size_t const cols = 38;
+  dash::Matrix<float, 2> A(dash::SizeSpec<2>(rows, cols),
+                           dash::DistributionSpec<2>(dash::TILE(8), dash::TILE(8)),
+                           dash::Team::All(),
+                           dash::TeamSpec<2>());
+  dash::Matrix<float, 2> B(A.pattern());
+  for (auto &tile : mephisto::local_tiles<std::size_t>(A)) {
+    for (std::size_t r = 0; r < tile.rows; ++r) {
+      for (std::size_t c = 0; c < tile.cols; ++c) {
+        A.lbegin()[tile.offset + r * tile.cols + c] =
+          static_cast<float>((tile.row + r) * cols + tile.col + c);
+      }
+    }
+  }
+  std::fill(B.lbegin(), B.lend(), -1.0f);
+  A.barrier();
+
+  std::string const path = "0008-io.tiled";
+  mephisto::write_tiled(A, path);
+
+  auto header = mephisto::read_tiled_header(path);
+  CHECK(header.rows == rows && header.cols == cols);
+  CHECK(header.tile_rows == 8 && header.tile_cols == 8);
+  CHECK(header.elem_size == sizeof(float));
+
+  mephisto::read_tiled(B, path);
+  for (std::size_t i = 0; i < A.local_size(); ++i) {
+    CHECK(B.lbegin()[i] == A.lbegin()[i]);
+  }
+
+  // A file with another tile size does not match
+  dash::Matrix<float, 2> C(dash::SizeSpec<2>(rows, cols),
+                           dash::DistributionSpec<2>(dash::TILE(4), dash::TILE(4)),
+                           dash::Team::All(),
+                           dash::TeamSpec<2>());
+  bool thrown = false;
+  try {
+    mephisto::read_tiled(C, path);
+  } catch (std::runtime_error &) {
+    thrown = true;
+  }
+  CHECK(thrown);
+
+  // Headers with an empty tile size or a size that overflows are rejected
+  std::string const invalid = "0008-io-" + std::to_string(dash::myid()) + ".tiled";
+  for (auto &bad : {mephisto::make_tiled_header(4, 4, 0, 4, 4),
+                    mephisto::make_tiled_header(4, 4, 4, 4, 0),
+                    mephisto::make_tiled_header(std::uint64_t(1) << 40, std::uint64_t(1) << 40, 1, 1, 8)}) {
+    std::ofstream out(invalid, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&bad), sizeof(bad));
+    out.close();
+    thrown = false;
+    try {
+      mephisto::read_tiled_header(invalid);
+    } catch (std::runtime_error &) {
+      thrown = true;
+    }
+    CHECK(thrown);
+  }
+  std::remove(invalid.c_str());
+
+  dash::Team::All().barrier();
+  if (dash::myid() == 0) {
+    std::remove(path.c_str());
+  }
+
+  dash::finalize();
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+#include <mephisto/bfloat16>
+#include <mephisto/gemv>
+
+#include "check.h"
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+using mephisto::bfloat16;
+
+// Small integers, so that all sums are exact in float and bfloat16 and
+// the kernels have to agree with the reference exactly
+template <typename T>
+std::vector<T> values(std::size_t n, int seed) {
+  std::vector<T> v(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    v[i] = static_cast<T>(static_cast<int>((i * 7 + seed * 13) % 9) - 4);
+  }
+  return v;
+}
+
+// y += A * x, one element at a time
+template <typename T, typename StorageT>
+void reference(T *y, const StorageT *A, const T *x, std::size_t M, std::size_t N) {
+  for (std::size_t m = 0; m < M; ++m) {
+    for (std::size_t n = 0; n < N; ++n) {
+      y[m] += static_cast<T>(A[m * N + n]) * x[n];
+    }
+  }
+}
+
+// y += A^T * x, one element at a time
+template <typename T>
+void reference_t(T *y, const T *A, const T *x, std::size_t M, std::size_t N) {
+  for (std::size_t m = 0; m < M; ++m) {
+    for (std::size_t n = 0; n < N; ++n) {
+      y[n] += A[m * N + n] * x[m];
+    }
+  }
+}
+
+template <typename T>
+void check_type() {
+  // Tile widths with and without an unrolled kernel, shorter and longer
+  // than the vector registers and the widening chunk of gemv_mixed
+  for (std::size_t N : {1, 3, 4, 7, 8, 16, 17, 32, 33, 64, 128, 130, 300}) {
+    for (std::size_t M : {1, 3, 4, 5, 9}) {
+      auto A = values<T>(M * N, 1);
+      auto x = values<T>(N, 2);
+      auto w = values<T>(M, 3);
+
+      auto expected = values<T>(M, 4);
+      reference(expected.data(), A.data(), x.data(), M, N);
+
+      auto y = values<T>(M, 4);
+      mephisto::gemv(y.data(), A.data(), x.data(), M, N);
+      CHECK(y == expected);
+
+      y = values<T>(M, 4);
+      mephisto::select_gemv<T>(N)(y.data(), A.data(), x.data(), M, N);
+      CHECK(y == expected);
+
+      // An unrolled kernel called with another width falls back
+      y = values<T>(M, 4);
+      mephisto::gemv<8>(y.data(), A.data(), x.data(), M, N);
+      CHECK(y == expected);
+
+      y = values<T>(M, 4);
+      mephisto::gemv_mixed(y.data(), A.data(), x.data(), M, N);
+      CHECK(y == expected);
+
+      std::vector<bfloat16> narrow(A.begin(), A.end());
+      y = values<T>(M, 4);
+      mephisto::gemv_mixed(y.data(), narrow.data(), x.data(), M, N);
+      CHECK(y == expected);
+
+      auto expected_t = values<T>(N, 5);
+      reference_t(expected_t.data(), A.data(), w.data(), M, N);
+
+      auto z = values<T>(N, 5);
+      mephisto::gemv_t(z.data(), A.data(), w.data(), M, N);
+      CHECK(z == expected_t);
+
+      y = values<T>(M, 4);
+      z = values<T>(N, 5);
+      mephisto::gemv_symmetric(y.data(), z.data(), A.data(), x.data(), w.data(), M, N);
+      CHECK(y == expected);
+      CHECK(z == expected_t);
+
+      for (std::size_t K : {1, 2, 3, 4, 8, 17, 33, 64}) {
+        auto X = values<T>(N * K, 6);
+        auto Y = values<T>(M * K, 7);
+        auto expected_multi = Y;
+        for (std::size_t k = 0; k < K; ++k) {
+          std::vector<T> xk(N), yk(M);
+          for (std::size_t n = 0; n < N; ++n) {
+            xk[n] = X[n * K + k];
+          }
+          for (std::size_t m = 0; m < M; ++m) {
+            yk[m] = Y[m * K + k];
+          }
+          reference(yk.data(), A.data(), xk.data(), M, N);
+          for (std::size_t m = 0; m < M; ++m) {
+            expected_multi[m * K + k] = yk[m];
+          }
+        }
+
+        mephisto::gemv_multi(Y.data(), A.data(), X.data(), M, N, K);
+        CHECK(Y == expected_multi);
+
+        Y = values<T>(M * K, 7);
+        mephisto::gemv_multi(Y.data(), narrow.data(), X.data(), M, N, K);
+        CHECK(Y == expected_multi);
+      }
+    }
+  }
+}
+
+int main() {
+  check_type<double>();
+  check_type<float>();
+
+  return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef MEPHISTO_T_CHECK
+#define MEPHISTO_T_CHECK
+
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * Fail the test if cond does not hold. Unlike assert, the check is also
+ * done in builds with NDEBUG.
+ */
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n",               \
+                   __FILE__, __LINE__, #cond);                        \
+      std::exit(EXIT_FAILURE);                                        \
+    }                                                                 \
+  } while (0)
+
+#endif
@@ -1,13 +1,30 @@
 #include <iostream>
 #include <sstream>
-#include <chrono>
+#include <cmath>
 #include <cassert>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
 
 //#include <libdash.h>
 #include <alpaka/alpaka.hpp>
 
+#include <mephisto/allocator>
+#include <mephisto/bench>
+#include <mephisto/bfloat16>
+#include <mephisto/layout>
+#include <mephisto/numa>
+#include <mephisto/pool>
+#include <mephisto/tiled_file>
+
 /**
+ * Initialize block blockCoord of the matrix, block points to its first
+ * element in the layout TLayout.
  */
+template<
+    typename TLayout = mephisto::BlockMajorLayout>
 struct HostInitBlockMatrix
 {
     template<
@@ -60,59 +77,111 @@ struct HostInitBlockMatrix
                 linearizedGlobalThreadIdx[0u] * BS + local_x,
                 value);
 #endif
-            block[linearizedGlobalThreadIdx[0u] * BS + local_x] = value;
+            block[linearizedGlobalThreadIdx[0u] * TLayout::row_stride(BS, NBS) + local_x] = value;
         }
     }
 };
 
 /**
+ * Initialize all blocks of the matrix in a single launch with the work
+ * division of BlockMultMatrixVector, so every page is first written by the
+ * thread that multiplies it later.
+ *
+ * Grid block row writes row row of every block, its threads stride over
+ * the columns like the multiplication does. The OpenMP accelerators hand
+ * grid blocks to threads statically, so a row of all blocks is touched
+ * and multiplied by the same thread and, with memory from
+ * alloc_first_touch, placed on its NUMA node.
  */
-struct HostInitBlockVector
+template<
+    typename TLayout = mephisto::BlockMajorLayout>
+struct FirstTouchBlockMatrix
+{
+    template<
+        typename TAcc,
+        typename TStorage,
+        typename TSize>
+    ALPAKA_FN_ACC auto operator()(
+        TAcc const & acc,
+        TStorage * const A,
+        TSize N,
+        TSize BS,
+        TSize NBS ) const
+    -> void
+    {
+        auto const row = alpaka::idx::getIdx<alpaka::Grid, alpaka::Blocks>(acc)[0u];
+        auto const thread_idx = alpaka::idx::getIdx<alpaka::Block, alpaka::Threads>(acc)[0u];
+        auto const threads = alpaka::workdiv::getWorkDiv<alpaka::Block, alpaka::Threads>(acc)[0u];
+        TSize const stride = TLayout::row_stride(BS, NBS);
+
+        for (TSize block_y = 0; block_y < NBS; ++block_y) {
+            TSize const global_y = block_y * BS + row;
+            for (TSize block_x = 0; block_x < NBS; ++block_x) {
+                TStorage * const A_row = A + TLayout::block_offset(block_y, block_x, BS, NBS) + row * stride;
+                for (auto i = thread_idx; i < BS; i += threads) {
+                    TSize const global_x = block_x * BS + i;
+                    A_row[i] = static_cast<TStorage>(
+                        (global_y < N && global_x < N) ? static_cast<double>(global_y * N + global_x) : 0.0);
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Initialize the K blocks of a vector for all block rows with the work
+ * division of BlockMultMatrixVector, like FirstTouchBlockMatrix does for
+ * the matrix.
+ *
+ * Grid block row writes element row of every block, which is the element
+ * of y that grid block sums up. The threads of a grid block stride over
+ * the K vectors. Elements beyond N are padding and set to invalidValue.
+ */
+struct FirstTouchBlockVector
 {
     template<
         typename TAcc,
         typename TData,
-        typename TSize,
-        typename TExtent>
-    ALPAKA_FN_ACC_NO_CUDA auto operator()(
+        typename TSize>
+    ALPAKA_FN_ACC auto operator()(
         TAcc const & acc,
-        TData * block,
+        TData * const v,
         TData initValue,
         TData invalidValue,
-        TSize blockIdx,
-        TExtent const & extents
-         ) const
+        TSize N,
+        TSize BS,
+        TSize NBS,
+        TSize K ) const
     -> void
     {
-        /**
-         * In the most cases the parallel work distibution depends
-         * on the current index of a thread and how many threads
-         * exist overall. These information can be obtained by
-         * getIdx() and getWorkDiv(). In this example these
-         * values are obtained for a global scope.
-         */
-        auto const globalThreadIdx = alpaka::idx::getIdx<alpaka::Grid, alpaka::Threads>(acc);
-        auto const globalThreadExtent = alpaka::workdiv::getWorkDiv<alpaka::Grid, alpaka::Threads>(acc);
-
-        /**
-         * Map the three dimensional thread index into a
-         * one dimensional thread index space. We call it
-         * linearize the thread index.
-         */
-        auto const linearizedGlobalThreadIdx = alpaka::idx::mapIdx<1u>(
-            globalThreadIdx,
-            globalThreadExtent);
+        auto const row = alpaka::idx::getIdx<alpaka::Grid, alpaka::Blocks>(acc)[0u];
+        auto const thread_idx = alpaka::idx::getIdx<alpaka::Block, alpaka::Threads>(acc)[0u];
+        auto const threads = alpaka::workdiv::getWorkDiv<alpaka::Block, alpaka::Threads>(acc)[0u];
 
-        TSize global_y = blockIdx * extents[2u] + globalThreadIdx[0u];
-
-        block[linearizedGlobalThreadIdx[0u]] = global_y < extents[0u] ? initValue : invalidValue;
+        for (TSize block = 0; block < NBS; ++block) {
+            TData const value = block * BS + row < N ? initValue : invalidValue;
+            for (auto k = thread_idx; k < K; k += threads) {
+                v[(block * K + k) * BS + row] = value;
+            }
+        }
     }
 };
 
 /**
+ * Multiply a BS x BS block of A with K blocks of x in a single launch.
+ *
+ * The grid has one block per row of the tile. The TThreads threads of a
+ * block each sum up a strided part of the row and the partial sums are
+ * combined with a tree reduction in shared memory. Every element of the
+ * row is loaded once and multiplied with all K vectors. The K blocks of x
+ * and y are stored one after the other, BS elements each. A may be stored
+ * in a narrower type than x and y, the sums are computed in the type of y.
+ * The rows of the block are TLayout::row_stride apart.
  */
 template<
-    int TThreads>
+    int TThreads,
+    int TMaxRhs = 1,
+    typename TLayout = mephisto::BlockMajorLayout>
 struct BlockMultMatrixVector
 {
     template<
@@ -141,43 +210,657 @@ struct BlockMultMatrixVector
     template<
         typename TAcc,
         typename TData,
+        typename TStorage,
         typename TSize>
     ALPAKA_FN_ACC auto operator()(
         TAcc const & acc,
         TData * const y,
-        TData const * const A,
+        TStorage const * const A,
         TData const * const x,
-        TSize BS ) const
+        TSize BS,
+        TSize NBS,
+        TSize K = 1 ) const
     -> void
     {
-        auto const globalThreadIdx = alpaka::idx::getIdx<alpaka::Grid, alpaka::Threads>(acc);
-        auto const globalThreadExtent = alpaka::workdiv::getWorkDiv<alpaka::Grid, alpaka::Threads>(acc);
-
-        auto const thread_idx = globalThreadIdx[0u];
-        auto threads = globalThreadExtent[0u];
+        auto const row = alpaka::idx::getIdx<alpaka::Grid, alpaka::Blocks>(acc)[0u];
+        auto const thread_idx = alpaka::idx::getIdx<alpaka::Block, alpaka::Threads>(acc)[0u];
+        auto threads = alpaka::workdiv::getWorkDiv<alpaka::Block, alpaka::Threads>(acc)[0u];
         assert(TThreads == threads);
+        assert(K <= TMaxRhs);
+
+        /* the partial sums of vector k start at prod[k * TThreads] */
+        auto && prod = alpaka::block::shared::st::allocVar<Array<TData, TThreads * TMaxRhs>, 0>(acc);
 
-        auto && prod = alpaka::block::shared::st::allocVar<Array<TData, TThreads>, 0>(acc);
+        TStorage const * const A_row = A + row * TLayout::row_stride(BS, NBS);
 
-        prod[thread_idx] = 0.0;
+        TData sum[TMaxRhs];
+        for (TSize k = 0; k < K; ++k) {
+            sum[k] = 0.0;
+        }
         for (auto i = thread_idx; i < BS; i += TThreads) {
-            prod[thread_idx] += A[i] * x[i];
+            TData const a = static_cast<TData>(A_row[i]);
+            for (TSize k = 0; k < K; ++k) {
+                sum[k] += a * x[k * BS + i];
+            }
+        }
+        for (TSize k = 0; k < K; ++k) {
+            prod[k * TThreads + thread_idx] = sum[k];
         }
         alpaka::block::sync::syncBlockThreads(acc);
 
         while (threads > 1) {
             threads /= 2;
             if (thread_idx < threads) {
-                prod[thread_idx] += prod[thread_idx + threads];
+                for (TSize k = 0; k < K; ++k) {
+                    prod[k * TThreads + thread_idx] += prod[k * TThreads + thread_idx + threads];
+                }
             }
             alpaka::block::sync::syncBlockThreads(acc);
         }
         if (thread_idx == 0) {
-            *y += prod[0];
+            for (TSize k = 0; k < K; ++k) {
+                y[k * BS + row] += prod[k * TThreads];
+            }
         }
     }
 };
 
+/**
+ * Copy block (block_y, block_x) of A, stored in the layout TLayout, into
+ * a contiguous BS x BS device buffer. Blocks whose rows are not adjacent
+ * are copied as a pitched 2D view.
+ */
+template<
+    typename TLayout,
+    typename TQueue,
+    typename TDevHost,
+    typename TDevAcc,
+    typename TStorage,
+    typename TSize>
+auto copyBlock(
+    TQueue & queue,
+    TDevHost const & devHost,
+    TDevAcc const & devAcc,
+    TStorage * deviceBlock,
+    TStorage * A,
+    TSize block_y,
+    TSize block_x,
+    TSize BS,
+    TSize NBS)
+-> void
+{
+    using Dim = alpaka::dim::DimInt<1>;
+    using Dim2 = alpaka::dim::DimInt<2>;
+    using Vec2 = alpaka::vec::Vec<Dim2, TSize>;
+
+    TStorage * hostBlock = A + TLayout::block_offset(block_y, block_x, BS, NBS);
+    TSize const stride = TLayout::row_stride(BS, NBS);
+    if (stride == BS) {
+        alpaka::mem::view::ViewPlainPtr<TDevHost, TStorage, Dim, TSize> hostBlockPlain(hostBlock, devHost, BS * BS);
+        alpaka::mem::view::ViewPlainPtr<TDevAcc, TStorage, Dim, TSize> deviceBlockPlain(deviceBlock, devAcc, BS * BS);
+        alpaka::mem::view::copy(queue, deviceBlockPlain, hostBlockPlain, BS * BS);
+    } else {
+        /* pitches of the whole block and of a row in bytes */
+        Vec2 const extent(BS, BS);
+        alpaka::mem::view::ViewPlainPtr<TDevHost, TStorage, Dim2, TSize> hostBlockPlain(hostBlock, devHost, extent,
+            Vec2(BS * stride * sizeof(TStorage), stride * sizeof(TStorage)));
+        alpaka::mem::view::ViewPlainPtr<TDevAcc, TStorage, Dim2, TSize> deviceBlockPlain(deviceBlock, devAcc, extent);
+        alpaka::mem::view::copy(queue, deviceBlockPlain, hostBlockPlain, extent);
+    }
+}
+
+/**
+ * Multiply block by block: every block of A and x is copied to the
+ * device and multiplied before the next one is copied. A is stored in
+ * the layout TLayout, its blocks are multiplied from contiguous device
+ * buffers.
+ *
+ * x and y hold K vectors in blocks: block b of vector k starts at
+ * (b * K + k) * BS, so the K vectors of a block are contiguous.
+ */
+template<
+    typename TAcc,
+    typename TLayout,
+    typename TQueue,
+    typename TWorkDiv,
+    typename TKernel,
+    typename TDevHost,
+    typename TDevAcc,
+    typename TStorage,
+    typename TData,
+    typename TSize>
+auto multiplySync(
+    TQueue & queueAcc,
+    TWorkDiv const & workDivAcc,
+    TKernel const & multMatricVectorKernel,
+    TDevHost const & devHost,
+    TDevAcc const & devAcc,
+    TStorage * A,
+    TData * x,
+    TData * y,
+    TSize BS,
+    TSize NBS,
+    TSize K)
+-> void
+{
+    using Dim = alpaka::dim::DimInt<1>;
+
+    auto& pool = mephisto::get_pool(devAcc);
+    auto deviceYBlock = pool.template alloc<TData>(BS * K);
+    auto deviceXBlock = pool.template alloc<TData>(BS * K);
+    auto deviceABlock = pool.template alloc<TStorage>(BS * BS);
+
+    for (TSize block_y = 0; block_y < NBS; block_y++) {
+        alpaka::mem::view::ViewPlainPtr<TDevHost, TData, Dim, TSize> hostYBlockPlain(&y[block_y * BS * K], devHost, BS * K);
+
+        /* copy y from host memory to device */
+        alpaka::mem::view::copy(queueAcc, deviceYBlock.view(), hostYBlockPlain, BS * K);
+
+        for (TSize block_x = 0; block_x < NBS; block_x++) {
+            alpaka::mem::view::ViewPlainPtr<TDevHost, TData, Dim, TSize> hostXBlockPlain(&x[block_x * BS * K], devHost, BS * K);
+
+            /* copy A from host memory to device */
+            copyBlock<TLayout>(queueAcc, devHost, devAcc, deviceABlock.data(), A, block_y, block_x, BS, NBS);
+            /* copy x from host memory to device */
+            alpaka::mem::view::copy(queueAcc, deviceXBlock.view(), hostXBlockPlain, BS * K);
+
+            alpaka::kernel::exec<TAcc>(queueAcc,
+                workDivAcc,
+                multMatricVectorKernel,
+                deviceYBlock.data(),
+                deviceABlock.data(),
+                deviceXBlock.data(),
+                BS, NBS, K);
+        }
+
+        /* copy y from device back into host memory */
+        alpaka::mem::view::copy(queueAcc, hostYBlockPlain, deviceYBlock.view(), BS * K);
+    }
+}
+
+/**
+ * Multiply with NB rotating device buffers for the blocks of A and x.
+ *
+ * Blocks are staged on queueCopy and multiplied on queueCompute, so block
+ * k + 1 is copied while block k is multiplied. Events order the two queues:
+ * staged[slot] is recorded once a block is copied into a slot and
+ * consumed[slot] once all kernels that read the slot are done, so a slot is
+ * not overwritten before it has been used. A is stored in the layout
+ * TLayout.
+ */
+template<
+    typename TAcc,
+    typename TLayout,
+    typename TQueue,
+    typename TWorkDiv,
+    typename TKernel,
+    typename TDevHost,
+    typename TDevAcc,
+    typename TStorage,
+    typename TData,
+    typename TSize>
+auto multiplyPipelined(
+    TQueue & queueCopy,
+    TQueue & queueCompute,
+    TWorkDiv const & workDivAcc,
+    TKernel const & multMatricVectorKernel,
+    TDevHost const & devHost,
+    TDevAcc const & devAcc,
+    TStorage * A,
+    TData * x,
+    TData * y,
+    TSize BS,
+    TSize NBS,
+    TSize NB,
+    TSize K)
+-> void
+{
+    using Dim = alpaka::dim::DimInt<1>;
+    using Event = alpaka::event::Event<TQueue>;
+    using ABufferT = typename mephisto::MemoryPool<TDevAcc>::template Buffer<TStorage>;
+    using XBufferT = typename mephisto::MemoryPool<TDevAcc>::template Buffer<TData>;
+
+    auto& pool = mephisto::get_pool(devAcc);
+    auto deviceYBlock = pool.template alloc<TData>(BS * K);
+
+    std::vector<ABufferT> deviceABlocks;
+    std::vector<XBufferT> deviceXBlocks;
+    std::vector<Event> staged;
+    std::vector<Event> consumed;
+    for (TSize slot = 0; slot < NB; slot++) {
+        deviceABlocks.push_back(pool.template alloc<TStorage>(BS * BS));
+        deviceXBlocks.push_back(pool.template alloc<TData>(BS * K));
+        staged.push_back(Event(devAcc));
+        consumed.push_back(Event(devAcc));
+    }
+
+    for (TSize block_y = 0; block_y < NBS; block_y++) {
+        alpaka::mem::view::ViewPlainPtr<TDevHost, TData, Dim, TSize> hostYBlockPlain(&y[block_y * BS * K], devHost, BS * K);
+
+        /* copy y from host memory to device */
+        alpaka::mem::view::copy(queueCompute, deviceYBlock.view(), hostYBlockPlain, BS * K);
+
+        for (TSize block_x = 0; block_x < NBS; block_x++) {
+            TSize block_linear = block_y * NBS + block_x;
+            TSize slot = block_linear % NB;
+
+            alpaka::mem::view::ViewPlainPtr<TDevHost, TData, Dim, TSize> hostXBlockPlain(&x[block_x * BS * K], devHost, BS * K);
+
+            /* the slot must not be overwritten before its last block is multiplied */
+            if (block_linear >= NB) {
+                alpaka::wait::wait(queueCopy, consumed[slot]);
+            }
+
+            /* stage A and x in the slot */
+            copyBlock<TLayout>(queueCopy, devHost, devAcc, deviceABlocks[slot].data(), A, block_y, block_x, BS, NBS);
+            alpaka::mem::view::copy(queueCopy, deviceXBlocks[slot].view(), hostXBlockPlain, BS * K);
+            alpaka::queue::enqueue(queueCopy, staged[slot]);
+
+            /* multiply as soon as the slot is staged */
+            alpaka::wait::wait(queueCompute, staged[slot]);
+            alpaka::kernel::exec<TAcc>(queueCompute,
+                workDivAcc,
+                multMatricVectorKernel,
+                deviceYBlock.data(),
+                deviceABlocks[slot].data(),
+                deviceXBlocks[slot].data(),
+                BS, NBS, K);
+            alpaka::queue::enqueue(queueCompute, consumed[slot]);
+        }
+
+        /* copy y from device back into host memory */
+        alpaka::mem::view::copy(queueCompute, hostYBlockPlain, deviceYBlock.view(), BS * K);
+    }
+
+    alpaka::wait::wait(queueCompute);
+    alpaka::wait::wait(queueCopy);
+}
+
+/**
+ * Multiply with the whole matrix resident on the device.
+ *
+ * deviceA holds all blocks of A in the layout TLayout, so only x and y
+ * are copied per product. The kernel has to read its rows with the same
+ * layout.
+ */
+template<
+    typename TAcc,
+    typename TLayout,
+    typename TQueue,
+    typename TWorkDiv,
+    typename TKernel,
+    typename TDevHost,
+    typename TBuf,
+    typename TStorage,
+    typename TData,
+    typename TSize>
+auto multiplyResident(
+    TQueue & queueAcc,
+    TWorkDiv const & workDivAcc,
+    TKernel const & multMatricVectorKernel,
+    TDevHost const & devHost,
+    TStorage const * deviceA,
+    TBuf & deviceX,
+    TBuf & deviceY,
+    TData * x,
+    TData * y,
+    TSize BS,
+    TSize NBS,
+    TSize K)
+-> void
+{
+    using Dim = alpaka::dim::DimInt<1>;
+
+    /* elements of all K vectors */
+    TSize NSK = NBS * BS * K;
+
+    alpaka::mem::view::ViewPlainPtr<TDevHost, TData, Dim, TSize> hostXPlain(x, devHost, NSK);
+    alpaka::mem::view::ViewPlainPtr<TDevHost, TData, Dim, TSize> hostYPlain(y, devHost, NSK);
+
+    /* copy x and y from host memory to device */
+    alpaka::mem::view::copy(queueAcc, deviceX.view(), hostXPlain, NSK);
+    alpaka::mem::view::copy(queueAcc, deviceY.view(), hostYPlain, NSK);
+
+    for (TSize block_y = 0; block_y < NBS; block_y++) {
+        for (TSize block_x = 0; block_x < NBS; block_x++) {
+            alpaka::kernel::exec<TAcc>(queueAcc,
+                workDivAcc,
+                multMatricVectorKernel,
+                deviceY.data() + block_y * BS * K,
+                deviceA + TLayout::block_offset(block_y, block_x, BS, NBS),
+                deviceX.data() + block_x * BS * K,
+                BS, NBS, K);
+        }
+    }
+
+    /* copy y from device back into host memory */
+    alpaka::mem::view::copy(queueAcc, hostYPlain, deviceY.view(), NSK);
+    alpaka::wait::wait(queueAcc);
+}
+
+/**
+ * Multiply block by block with the blocks of A read from a file.
+ *
+ * The blocks come from a TileStream in file order, which is the order of
+ * the block loop, so host memory is only needed for the blocks in its
+ * ring and the matrix may exceed the memory of the node. The stream reads
+ * ahead while the current block is copied and multiplied.
+ *
+ * Like in multiplyPipelined, blocks are staged in NB device slots on
+ * queueCopy and multiplied on queueCompute, ordered by the events staged
+ * and consumed. A block of the stream is handed back as soon as the event
+ * recorded after its copy has passed, so the host never waits for a
+ * kernel and the next copy overlaps with the current product.
+ */
+template<
+    typename TAcc,
+    typename TQueue,
+    typename TWorkDiv,
+    typename TKernel,
+    typename TDevHost,
+    typename TDevAcc,
+    typename TStorage,
+    typename TData,
+    typename TSize>
+auto multiplyStreamed(
+    TQueue & queueCopy,
+    TQueue & queueCompute,
+    TWorkDiv const & workDivAcc,
+    TKernel const & multMatricVectorKernel,
+    TDevHost const & devHost,
+    TDevAcc const & devAcc,
+    mephisto::TileStream<TStorage> & A,
+    TData * x,
+    TData * y,
+    TSize BS,
+    TSize NBS,
+    TSize NB,
+    TSize K)
+-> void
+{
+    using Dim = alpaka::dim::DimInt<1>;
+    using Event = alpaka::event::Event<TQueue>;
+    using ABufferT = typename mephisto::MemoryPool<TDevAcc>::template Buffer<TStorage>;
+    using XBufferT = typename mephisto::MemoryPool<TDevAcc>::template Buffer<TData>;
+
+    auto& pool = mephisto::get_pool(devAcc);
+    auto deviceYBlock = pool.template alloc<TData>(BS * K);
+
+    std::vector<ABufferT> deviceABlocks;
+    std::vector<XBufferT> deviceXBlocks;
+    std::vector<Event> staged;
+    std::vector<Event> consumed;
+    for (TSize slot = 0; slot < NB; slot++) {
+        deviceABlocks.push_back(pool.template alloc<TStorage>(BS * BS));
+        deviceXBlocks.push_back(pool.template alloc<TData>(BS * K));
+        staged.push_back(Event(devAcc));
+        consumed.push_back(Event(devAcc));
+    }
+
+    /* blocks taken from the stream and blocks handed back */
+    TSize acquired = 0;
+    TSize released = 0;
+
+    for (TSize block_y = 0; block_y < NBS; block_y++) {
+        alpaka::mem::view::ViewPlainPtr<TDevHost, TData, Dim, TSize> hostYBlockPlain(&y[block_y * BS * K], devHost, BS * K);
+
+        /* copy y from host memory to device */
+        alpaka::mem::view::copy(queueCompute, deviceYBlock.view(), hostYBlockPlain, BS * K);
+
+        for (TSize block_x = 0; block_x < NBS; block_x++) {
+            TSize block_linear = block_y * NBS + block_x;
+            TSize slot = block_linear % NB;
+
+            /* hand back the blocks whose copy is done, and wait for the
+             * oldest one if all ring slots are taken */
+            while (released < acquired
+                   && (acquired - released == NB || alpaka::event::test(staged[released % NB]))) {
+                alpaka::wait::wait(staged[released % NB]);
+                A.release();
+                released++;
+            }
+
+            alpaka::mem::view::ViewPlainPtr<TDevHost, TStorage, Dim, TSize> hostABlockPlain(A.acquire(), devHost, BS * BS);
+            acquired++;
+            alpaka::mem::view::ViewPlainPtr<TDevHost, TData, Dim, TSize> hostXBlockPlain(&x[block_x * BS * K], devHost, BS * K);
+
+            /* the slot must not be overwritten before its last block is multiplied */
+            if (block_linear >= NB) {
+                alpaka::wait::wait(queueCopy, consumed[slot]);
+            }
+
+            /* stage A and x in the slot */
+            alpaka::mem::view::copy(queueCopy, deviceABlocks[slot].view(), hostABlockPlain, BS * BS);
+            alpaka::mem::view::copy(queueCopy, deviceXBlocks[slot].view(), hostXBlockPlain, BS * K);
+            alpaka::queue::enqueue(queueCopy, staged[slot]);
+
+            /* multiply as soon as the slot is staged */
+            alpaka::wait::wait(queueCompute, staged[slot]);
+            alpaka::kernel::exec<TAcc>(queueCompute,
+                workDivAcc,
+                multMatricVectorKernel,
+                deviceYBlock.data(),
+                deviceABlocks[slot].data(),
+                deviceXBlocks[slot].data(),
+                BS, NBS, K);
+            alpaka::queue::enqueue(queueCompute, consumed[slot]);
+        }
+
+        /* copy y from device back into host memory */
+        alpaka::mem::view::copy(queueCompute, hostYBlockPlain, deviceYBlock.view(), BS * K);
+    }
+
+    alpaka::wait::wait(queueCompute);
+    alpaka::wait::wait(queueCopy);
+    for (; released < acquired; released++) {
+        A.release();
+    }
+}
+
+/**
+ * Write the matrix of HostInitBlockMatrix to a file in the tiled format,
+ * generating one block at a time so the matrix is never held in memory.
+ * Returns false if the file cannot be written.
+ */
+template<
+    typename THost,
+    typename TStorage,
+    typename TQueue,
+    typename TWorkDiv,
+    typename TExtent,
+    typename TSize>
+auto writeTiledMatrix(
+    std::string const & path,
+    TQueue & queueHost,
+    TWorkDiv const & workDivHost,
+    TExtent const & blockGridExtent,
+    TSize N,
+    TSize BS,
+    TSize NBS)
+-> bool
+{
+    using Dim2 = alpaka::dim::DimInt<2>;
+
+    /* the blocks of the file are contiguous */
+    HostInitBlockMatrix<mephisto::BlockMajorLayout> initMatrixKernel;
+
+    auto const header = mephisto::make_tiled_header(N, N, BS, BS, sizeof(TStorage));
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+
+    std::vector<double> block(BS * BS);
+    std::vector<TStorage> stored(BS * BS);
+    for (TSize block_y = 0; block_y < NBS; block_y++) {
+        for (TSize block_x = 0; block_x < NBS; block_x++) {
+            const alpaka::vec::Vec<Dim2, TSize> block_grid_coord(block_y, block_x);
+            alpaka::kernel::exec<THost>(queueHost,
+                workDivHost,
+                initMatrixKernel,
+                block.data(),
+                blockGridExtent,
+                block_grid_coord);
+            std::copy(block.begin(), block.end(), stored.begin());
+            out.write(reinterpret_cast<char const *>(stored.data()), BS * BS * sizeof(TStorage));
+        }
+    }
+    out.close();
+    if (!out) {
+        std::cerr << "cannot write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Initialize the K blocks of a vector with one launch of
+ * FirstTouchBlockVector on TAcc and check their elements.
+ */
+template<
+    typename TAcc,
+    typename TQueue,
+    typename TWorkDiv,
+    typename TData,
+    typename TSize>
+auto initVector(
+    TQueue & queue,
+    TWorkDiv const & workDiv,
+    char const * name,
+    TData * v,
+    TData initValue,
+    TSize N,
+    TSize BS,
+    TSize NBS,
+    TSize K)
+-> void
+{
+    FirstTouchBlockVector firstTouchKernel;
+    alpaka::kernel::exec<TAcc>(queue, workDiv, firstTouchKernel, v, initValue, TData(0), N, BS, NBS, K);
+    alpaka::wait::wait(queue);
+
+    for (TSize block = 0; block < NBS; block++) {
+        for (TSize k = 0; k < K; k++) {
+            for (TSize local = 0; local < BS; local++) {
+                TSize global = block * BS + local;
+                TData value = (global < N) ? initValue : TData(0);
+                if (v[(block * K + k) * BS + local] != value)
+                    printf("%s[%zu,%zu]: %f != %f\n", name, global, k,
+                           static_cast<double>(v[(block * K + k) * BS + local]), static_cast<double>(value));
+            }
+        }
+    }
+}
+
+/**
+ * Initialize all blocks of A in the layout TLayout with one launch of
+ * FirstTouchBlockMatrix on TAcc and check their elements.
+ */
+template<
+    typename TAcc,
+    typename TLayout,
+    typename TQueue,
+    typename TWorkDiv,
+    typename TStorage,
+    typename TSize>
+auto initMatrix(
+    TQueue & queue,
+    TWorkDiv const & workDiv,
+    TStorage * A,
+    TSize N,
+    TSize BS,
+    TSize NBS)
+-> void
+{
+    FirstTouchBlockMatrix<TLayout> firstTouchKernel;
+    alpaka::kernel::exec<TAcc>(queue, workDiv, firstTouchKernel, A, N, BS, NBS);
+    alpaka::wait::wait(queue);
+
+    TSize const stride = TLayout::row_stride(BS, NBS);
+    for (TSize block_y = 0; block_y < NBS; block_y++) {
+        for (TSize block_x = 0; block_x < NBS; block_x++) {
+            auto A_block = &A[TLayout::block_offset(block_y, block_x, BS, NBS)];
+            for (TSize local_y = 0; local_y < BS; local_y++) {
+                TSize global_y = block_y * BS + local_y;
+                for (TSize local_x = 0; local_x < BS; local_x++) {
+                    TSize global_x = block_x * BS + local_x;
+                    TStorage A_value = static_cast<TStorage>(
+                        (global_y < N && global_x < N) ? static_cast<double>(global_y * N + global_x) : 0.0);
+                    if (A_block[local_y * stride + local_x] != A_value)
+                        printf("A[%zu,%zu]: %f != %f\n", global_y, global_x,
+                               static_cast<double>(A_block[local_y * stride + local_x]), static_cast<double>(A_value));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Add the product of the block (block_y, block_x) of A, whose rows are
+ * stride elements apart, with the K vectors of x to the reference result
+ * yRef and the product of the absolute values to yAbs. Runs on the host
+ * and sums up in double.
+ */
+template<
+    typename TStorage,
+    typename TData,
+    typename TSize>
+auto referenceBlock(
+    double * yRef,
+    double * yAbs,
+    TStorage const * block,
+    TSize stride,
+    TData const * x,
+    TSize block_y,
+    TSize block_x,
+    TSize BS,
+    TSize K)
+-> void
+{
+    for (TSize k = 0; k < K; k++) {
+        auto const x_block = &x[block_x * BS * K + k * BS];
+        auto const offset = block_y * BS * K + k * BS;
+        for (TSize local_y = 0; local_y < BS; local_y++) {
+            double sum = 0.0;
+            double abs = 0.0;
+            for (TSize local_x = 0; local_x < BS; local_x++) {
+                double const p = static_cast<double>(block[local_y * stride + local_x]) * x_block[local_x];
+                sum += p;
+                abs += std::abs(p);
+            }
+            yRef[offset + local_y] += sum;
+            yAbs[offset + local_y] += abs;
+        }
+    }
+}
+
+/**
+ * A result for K products with an N x N matrix stored as TStorage: every
+ * element of A is read once and used for 2 flops per vector, x and y are
+ * moved once.
+ */
+template<
+    typename TStorage,
+    typename TData,
+    typename TSize>
+auto makeResult(
+    std::string const & name,
+    std::string const & storage,
+    TSize N,
+    TSize K,
+    mephisto::BenchStats const & stats)
+-> mephisto::BenchResult
+{
+    mephisto::BenchResult result;
+    result.name = name;
+    result.rows = N;
+    result.cols = N;
+    result.rhs = K;
+    result.storage = storage;
+    result.stats = stats;
+    result.flops = 2.0 * N * N * K;
+    result.bytes = (double)N * N * sizeof(TStorage) + 2.0 * N * K * sizeof(TData);
+    return result;
+}
+
 auto
 main(
     int ac,
@@ -217,6 +900,7 @@ main(
 #ifdef USE_GPU
     using Acc = alpaka::acc::AccGpuCudaRt<Dim, Size>;
     using QueueAcc = alpaka::queue::QueueCudaRtSync;
+    using QueueAccAsync = alpaka::queue::QueueCudaRtAsync;
 #else
 //#define USE_OMP_2_THREADS
 #ifdef USE_OMP_2_THREADS
@@ -225,6 +909,7 @@ main(
     using Acc = alpaka::acc::AccCpuOmp2Blocks<Dim, Size>;
 #endif
     using QueueAcc = alpaka::queue::QueueCpuSync;
+    using QueueAccAsync = alpaka::queue::QueueCpuAsync;
 #endif
     using DevAcc = alpaka::dev::Dev<Acc>;
     using PltfAcc = alpaka::pltf::Pltf<DevAcc>;
@@ -240,13 +925,135 @@ main(
         in >> BS;
     }
 
+    /* sync, pipelined, resident, all, or stream to read the blocks of A
+     * from a file through a ring of NB blocks */
+    std::string mode = "all";
+    if (ac > 3) {
+        mode = av[3];
+    }
+    Size NB = 2;    /* Number of block buffers in pipelined and stream mode */
+    if (ac > 4) {
+        std::istringstream in(av[4]);
+        in >> NB;
+    }
+    NB = std::max<Size>(NB, 1);
+    Size R = 10;    /* Number of products per warm run in resident mode */
+    if (ac > 5) {
+        std::istringstream in(av[5]);
+        long repetitions = 0;
+        if (!(in >> repetitions) || !in.eof() || repetitions <= 0) {
+            std::cerr << "invalid number of products per warm run " << av[5] << std::endl;
+            return EXIT_FAILURE;
+        }
+        R = repetitions;
+    }
+    constexpr Size MaxRhs(32);
+    Size K = 1;     /* Number of right-hand sides */
+    if (ac > 6) {
+        std::istringstream in(av[6]);
+        in >> K;
+    }
+    K = std::max<Size>(K, 1);
+    if (K > MaxRhs) {
+        std::cerr << "at most " << MaxRhs << " right-hand sides are supported" << std::endl;
+        return EXIT_FAILURE;
+    }
+    /* storage type of the matrix: double, float or bf16 */
+    std::string storage = "double";
+    if (ac > 7) {
+        storage = av[7];
+    }
+    /* matrix file in the tiled format for stream mode. An existing file
+     * sets N, BS and the storage type, a missing one is generated. */
+    std::string matrix_file;
+    if (ac > 8) {
+        matrix_file = av[8];
+    }
+    /* layout of the matrix in host memory: row, block or zorder */
+    std::string layout = mephisto::BlockMajorLayout::name();
+    if (ac > 9) {
+        layout = av[9];
+    }
+    /* allocation of host buffers, pages[:alignment] with pages default,
+     * thp or huge */
+    if (ac > 10) {
+        try {
+            mephisto::default_allocation_policy() = mephisto::parse_allocation_policy(av[10]);
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    /* reporting of the timings, format[:warmup[:repetitions[:file]]] with
+     * format text, csv or json, followed by +stream to compare the results
+     * with the STREAM triad bandwidth */
+    mephisto::BenchConfig bench;
+    if (ac > 11) {
+        try {
+            bench = mephisto::parse_bench_config(av[11]);
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (mode != "sync" && mode != "pipelined" && mode != "resident" && mode != "all"
+        && mode != "stream") {
+        std::cerr << "unknown mode " << mode << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (layout != mephisto::RowMajorLayout::name() && layout != mephisto::BlockMajorLayout::name()
+        && layout != mephisto::ZOrderLayout::name()) {
+        std::cerr << "unknown layout " << layout << std::endl;
+        return EXIT_FAILURE;
+    }
+    bool const streamed = mode == "stream";
+    bool const generate = streamed && !std::ifstream(matrix_file).good();
+    if (streamed && matrix_file.empty()) {
+        std::cerr << "stream mode needs a matrix file" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (streamed && !generate) {
+        auto const header = mephisto::read_tiled_header(matrix_file);
+        if (header.rows != header.cols || header.tile_rows != header.tile_cols) {
+            std::cerr << matrix_file << " has no square matrix or blocks" << std::endl;
+            return EXIT_FAILURE;
+        }
+        N = header.rows;
+        BS = header.tile_rows;
+        storage = header.elem_size == sizeof(float) ? "float"
+                : header.elem_size == sizeof(mephisto::bfloat16) ? "bf16"
+                : header.elem_size == sizeof(double) ? "double"
+                : "";
+        if (storage.empty()) {
+            std::cerr << matrix_file << " has elements of " << header.elem_size
+                      << " bytes" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (storage != "double" && storage != "float" && storage != "bf16") {
+        std::cerr << "unknown storage type " << storage << std::endl;
+        return EXIT_FAILURE;
+    }
+
     Size NBS = (N + (BS - 1)) / BS;
     Size NS = NBS * BS;
 
     std::cout << "N   = " << N << "\n"
               << "BS  = " << BS << "\n"
               << "NBS = " << NBS << "\n"
-              << "NS  = " << NS << "\n";
+              << "NS  = " << NS << "\n"
+              << "NB  = " << NB << "\n"
+              << "R   = " << R << "\n"
+              << "K   = " << K << "\n"
+              << "storage: " << storage << "\n"
+              << "layout: " << layout << "\n"
+              << "alloc: " << mephisto::to_string(mephisto::default_allocation_policy()) << "\n"
+              << "mode: " << mode << "\n";
+
+    /* the host memory bandwidth the products are compared to, 256 MB per
+     * array, only measured on request */
+    double const ceiling = bench.stream ? mephisto::stream_triad_bandwidth(Size(1) << 25) : 0.0;
+    mephisto::BenchReport report("alpaka-mxv", bench, ceiling);
 
     /**
      * Get the first devices
@@ -279,13 +1086,16 @@ main(
 #endif
 #endif
 
+    /* one block of CS threads per row of a matrix block */
     WorkDiv const workDivAcc(
-        alpaka::workdiv::getValidWorkDiv<Acc>(
-            devAcc,
-            CS,
-            Size(1u),
-            false,
-            alpaka::workdiv::GridBlockExtentSubDivRestrictions::Unrestricted));
+        alpaka::vec::Vec<Dim, Size>(BS),
+        alpaka::vec::Vec<Dim, Size>(CS),
+        alpaka::vec::Vec<Dim, Size>(Size(1u)));
+    if (!alpaka::workdiv::isValidWorkDiv<Acc>(devAcc, workDivAcc)) {
+        std::cerr << "no valid work division for " << BS << " blocks of " << CS
+                  << " threads" << std::endl;
+        return EXIT_FAILURE;
+    }
 
     std::cout << "Host: " << alpaka::acc::getAccName<Host>() << " " << workDivHost << "\n"
               << "Acc:  " << alpaka::acc::getAccName<Acc>()  << " " << workDivAcc  << "\n";
@@ -305,6 +1115,31 @@ main(
     QueueHost queueHost(devHost);
     QueueAcc queueAcc(devAcc);
 
+#ifdef USE_GPU
+    /* the device cannot write host memory, touch A on the host by rows */
+    using AccTouch = Host;
+    auto & queueTouch = queueHost;
+    WorkDiv const workDivTouch(
+        alpaka::vec::Vec<Dim, Size>(BS),
+        alpaka::vec::Vec<Dim, Size>(Size(1u)),
+        alpaka::vec::Vec<Dim, Size>(Size(1u)));
+#else
+    /* the accelerator runs on host memory, so A is touched with the work
+     * division of the multiplication */
+    using AccTouch = Acc;
+    auto & queueTouch = queueAcc;
+    auto const & workDivTouch = workDivAcc;
+#endif
+
+    /* Create the matrix and vectors, a streamed matrix is never held in
+     * memory. The pages are placed when they are first written. */
+    Data *A = streamed ? nullptr : mephisto::alloc_first_touch<Data>(NS * NS);
+    Data *x = mephisto::alloc_first_touch<Data>(NS * K);
+    Data *y = mephisto::alloc_first_touch<Data>(NS * K);
+
+    using Dim3 = alpaka::dim::DimInt<3>;
+    const alpaka::vec::Vec<Dim3, Size> block_grid_extent(N, NBS, BS);
+
     /**
      * Run kernel
      *
@@ -316,156 +1151,247 @@ main(
      * accelerator queue. The enqueuing can be done
      * synchronously or asynchronously depending on the choosen
      * queue (see type definitions above).
+     *
+     * x and y are touched like A, by the threads that multiply their rows.
      */
-    HostInitBlockMatrix initMatrixKernel;
-    HostInitBlockVector initVectorKernel;
+    initVector<AccTouch>(queueTouch, workDivTouch, "x", x, Data(1.0), N, BS, NBS, K);
+    initVector<AccTouch>(queueTouch, workDivTouch, "y", y, Data(0.0), N, BS, NBS, K);
 
-    /* Create the matrix and vectors */
-    Data *A = new Data[NS * NS];
-    Data *x = new Data[NS];
-    Data *y = new Data[NS];
+    if (A != nullptr) {
+        mephisto::with_layout(layout, [&](auto layoutTag) {
+            initMatrix<AccTouch, decltype(layoutTag)>(queueTouch, workDivTouch, A, N, BS, NBS);
+        });
+    }
 
-    using Dim2 = alpaka::dim::DimInt<2>;
-    using Dim3 = alpaka::dim::DimInt<3>;
-    const alpaka::vec::Vec<Dim3, Size> block_grid_extent(N, NBS, BS);
+    /* call f with the kernel for K right-hand sides and the layout of
+     * layoutTag; a single right-hand side gets a kernel without shared
+     * memory for the others */
+    auto withKernel = [&](auto layoutTag, auto && f) {
+        using Layout = decltype(layoutTag);
+        if (K == 1) {
+            f(BlockMultMatrixVector<CS, 1, Layout>());
+        } else {
+            f(BlockMultMatrixVector<CS, MaxRhs, Layout>());
+        }
+    };
 
-    for (Size block_y = 0; block_y < NBS; block_y++) {
-        auto y_block = &y[block_y * BS];
-        auto x_block = &x[block_y * BS];
-
-        alpaka::kernel::exec<Host>(queueHost,
-            workDivHost,
-            initVectorKernel,
-            x_block,
-            1.0, 0.0,
-            block_y,
-            block_grid_extent);
-        alpaka::kernel::exec<Host>(queueHost,
-            workDivHost,
-            initVectorKernel,
-            y_block,
-            0.0, 0.0,
-            block_y,
-            block_grid_extent);
-
-        for (Size block_x = 0; block_x < NBS; block_x++) {
-            Size block_linear = block_y * NBS + block_x;
-
-            /* @todo make block available in device memory */
-            auto A_block = &A[block_linear * BS * BS];
-            const alpaka::vec::Vec<Dim2, Size> block_grid_coord(block_y, block_x);
-            alpaka::kernel::exec<Host>(queueHost,
-                workDivHost,
-                initMatrixKernel,
-                A_block,
-                block_grid_extent,
-                block_grid_coord);
+    auto& pool = mephisto::get_pool(devAcc);
 
-            for (Size local_y = 0; local_y < BS; local_y++) {
-                Size global_y = block_y * BS + local_y;
-                Data x_value = (global_y < N) ? 1.0 : 0.0;
-                Data y_value = (global_y < N) ? 0.0 : 0.0;
+    if (streamed) {
+        /* the type the pointer points to selects the storage type of the
+         * file, false if the generated file cannot be written */
+        auto multiplyStream = [&](auto * tag) {
+            using Storage = typename std::remove_pointer<decltype(tag)>::type;
 
-                if (x_block[local_y] != x_value)
-                    printf("x[%zu]: %f != %f\n", global_y, x_block[local_y], x_value);
-                if (y_block[local_y] != y_value)
-                    printf("y[%zu]: %f != %f\n", global_y, y_block[local_y], y_value);
+            if (generate && !writeTiledMatrix<Host, Storage>(matrix_file, queueHost, workDivHost,
+                                block_grid_extent, N, BS, NBS)) {
+                return false;
+            }
+            std::cout << "ring: " << NB * BS * BS * sizeof(Storage) << " bytes" << std::endl;
 
-#if 0
-                printf("x[local x:%zu] [global x:%zu] %f\n",
-                       local_y, global_y, x_block[local_y]);
+            QueueAccAsync queueCopy(devAcc);
+            QueueAccAsync queueCompute(devAcc);
 
-                printf("y[local x:%zu] [global x:%zu] %f\n",
-                       local_y, global_y, y_block[local_y]);
-#endif
-                for (Size local_x = 0; local_x < BS; local_x++) {
-                    Size global_x = block_x * BS + local_x;
-                    Size local_linear = local_y * BS + local_x;
-                    Size global_linear = block_linear * BS * BS + local_linear;
-                    Data A_value = (global_y < N && global_x < N) ? (global_y * N + global_x) : 0.;
-#if 0
-                    printf("A[block y:%2zu x:%2zu linear:%3zu] [local y:%2zu x:%2zu linear:%3zu] [global y:%2zu x:%2zu linear:%3zu]: %f\n",
-                            block_y, block_x, block_linear,
-                            local_y, local_x,
-                            local_linear, /* local linear */
-                            global_y,
-                            global_x,
-                            global_linear,
-                            A_value);
-#endif
-                    if (A_block[local_linear] != A_value)
-                        printf("A[%zu,%zu]: %f != %f\n", global_y, global_x, A_block[local_linear], A_value);
+            /* every run reads the whole file through a new ring */
+            auto stats = mephisto::summarize(mephisto::measure(bench,
+                [&] {
+                    mephisto::TileStream<Storage> stream(matrix_file, NB);
+                    withKernel(mephisto::BlockMajorLayout(), [&](auto const & kernel) {
+                        multiplyStreamed<Acc>(queueCopy, queueCompute, workDivAcc, kernel,
+                            devHost, devAcc, stream, x, y, BS, NBS, NB, K);
+                    });
+                },
+                [&] { std::fill(y, y + NS * K, 0.0); }));
+
+            /* the reference product reads the blocks of the file once more */
+            std::vector<double> yRef(NS * K, 0.0);
+            std::vector<double> yAbs(NS * K, 0.0);
+            mephisto::TileStream<Storage> stream(matrix_file, NB);
+            for (Size block_y = 0; block_y < NBS; block_y++) {
+                for (Size block_x = 0; block_x < NBS; block_x++) {
+                    referenceBlock(yRef.data(), yAbs.data(), stream.acquire(), BS, x,
+                        block_y, block_x, BS, K);
+                    stream.release();
                 }
             }
+
+            auto result = makeResult<Storage, Data>("stream(" + std::to_string(NB) + ")",
+                storage, N, K, stats);
+            result.error = mephisto::product_error(y, yRef.data(), yAbs.data(), NS * K);
+            result.tolerance = mephisto::product_tolerance<Storage>(N);
+            report.add(result);
+            return true;
+        };
+
+        bool written;
+        if (storage == "float") {
+            written = multiplyStream(static_cast<float *>(nullptr));
+        } else if (storage == "bf16") {
+            written = multiplyStream(static_cast<mephisto::bfloat16 *>(nullptr));
+        } else {
+            written = multiplyStream(static_cast<Data *>(nullptr));
         }
+
+        if (written) {
+            std::cout << pool.statistics() << std::endl;
+            report.write();
+        }
+
+        mephisto::free_first_touch(x, NS * K);
+        mephisto::free_first_touch(y, NS * K);
+        mephisto::release_pools<DevAcc>();
+        return written && report.passed() ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-#if 1
-    BlockMultMatrixVector<CS> multMatricVectorKernel;
+    /* run the products with A stored in the type AS points to and in the
+     * layout of layoutTag */
+    auto multiplyModes = [&](auto * AS, auto layoutTag) {
+        using Storage = typename std::remove_pointer<decltype(AS)>::type;
+        using Layout = decltype(layoutTag);
+
+        /* the reference product with the double matrix, so the error of
+         * the narrow storage types includes their rounding */
+        std::vector<double> yRef(NS * K, 0.0);
+        std::vector<double> yAbs(NS * K, 0.0);
+        for (Size block_y = 0; block_y < NBS; block_y++) {
+            for (Size block_x = 0; block_x < NBS; block_x++) {
+                referenceBlock(yRef.data(), yAbs.data(),
+                    &A[Layout::block_offset(block_y, block_x, BS, NBS)],
+                    Layout::row_stride(BS, NBS), x, block_y, block_x, BS, K);
+            }
+        }
 
-    alpaka::mem::buf::Buf<DevAcc, Data, Dim, Size> deviceYBlock(alpaka::mem::buf::alloc<Data, Size>(devAcc, BS));
-    alpaka::mem::buf::Buf<DevAcc, Data, Dim, Size> deviceXBlock(alpaka::mem::buf::alloc<Data, Size>(devAcc, BS));
-    alpaka::mem::buf::Buf<DevAcc, Data, Dim, Size> deviceABlock(alpaka::mem::buf::alloc<Data, Size>(devAcc, BS * BS));
+        /* every product adds to y, so it is cleared before every run */
+        auto clearY = [&] { std::fill(y, y + NS * K, 0.0); };
 
-    // Take the time prior to the execution.
-    auto const tpStart(std::chrono::high_resolution_clock::now());
+        auto checkedResult = [&](std::string const & name, mephisto::BenchStats const & stats) {
+            auto result = makeResult<Storage, Data>(name, storage, N, K, stats);
+            result.error = mephisto::product_error(y, yRef.data(), yAbs.data(), NS * K);
+            result.tolerance = mephisto::product_tolerance<Storage>(N);
+            return result;
+        };
 
-    for (Size block_y = 0; block_y < NBS; block_y++) {
-        alpaka::mem::view::ViewPlainPtr<DevHost, Data, Dim, Size> hostYBlockPlain(&y[block_y * BS], devHost, BS);
+        if (mode == "sync" || mode == "all") {
+            auto stats = mephisto::summarize(mephisto::measure(bench,
+                [&] {
+                    /* the staged modes multiply contiguous device blocks */
+                    withKernel(mephisto::BlockMajorLayout(), [&](auto const & kernel) {
+                        multiplySync<Acc, Layout>(queueAcc, workDivAcc, kernel,
+                            devHost, devAcc, AS, x, y, BS, NBS, K);
+                    });
+                },
+                clearY));
+            report.add(checkedResult("sync", stats));
+        }
 
-        /* copy y from host memory to device */
-        alpaka::mem::view::copy(queueAcc, deviceYBlock, hostYBlockPlain, BS);
+        if (mode == "pipelined" || mode == "all") {
+            QueueAccAsync queueCopy(devAcc);
+            QueueAccAsync queueCompute(devAcc);
 
-        for (Size block_x = 0; block_x < NBS; block_x++) {
-            Size block_linear = block_y * NBS + block_x;
+            auto stats = mephisto::summarize(mephisto::measure(bench,
+                [&] {
+                    withKernel(mephisto::BlockMajorLayout(), [&](auto const & kernel) {
+                        multiplyPipelined<Acc, Layout>(queueCopy, queueCompute, workDivAcc, kernel,
+                            devHost, devAcc, AS, x, y, BS, NBS, NB, K);
+                    });
+                },
+                clearY));
+            report.add(checkedResult("pipelined(" + std::to_string(NB) + ")", stats));
+        }
 
-            alpaka::mem::view::ViewPlainPtr<DevHost, Data, Dim, Size> hostABlockPlain(&A[block_linear * BS * BS], devHost, BS * BS);
-            alpaka::mem::view::ViewPlainPtr<DevHost, Data, Dim, Size> hostXBlockPlain(&x[block_x * BS], devHost, BS);
+        if (mode == "resident" || mode == "all") {
+            alpaka::mem::view::ViewPlainPtr<DevHost, Storage, Dim, Size> hostAPlain(AS, devHost, NS * NS);
 
-            /* copy A from host memory to device */
-            alpaka::mem::view::copy(queueAcc, deviceABlock, hostABlockPlain, BS * BS);
-            /* copy x from host memory to device */
-            alpaka::mem::view::copy(queueAcc, deviceXBlock, hostXBlockPlain, BS);
+            /* a cold run uploads the matrix before its product */
+            auto cold = mephisto::summarize(mephisto::measure(bench,
+                [&] {
+                    auto deviceA = pool.template alloc<Storage>(NS * NS);
+                    auto deviceX = pool.template alloc<Data>(NS * K);
+                    auto deviceY = pool.template alloc<Data>(NS * K);
+#ifndef USE_GPU
+                    /* the kernels read deviceA, place its pages before the upload */
+                    alpaka::kernel::exec<Acc>(queueAcc, workDivAcc, FirstTouchBlockMatrix<Layout>(),
+                        deviceA.data(), N, BS, NBS);
+#endif
+                    alpaka::mem::view::copy(queueAcc, deviceA.view(), hostAPlain, NS * NS);
 
-            for (Size block_r = 0; block_r < BS; block_r++) {
+                    /* the resident mode reads the blocks in place */
+                    withKernel(layoutTag, [&](auto const & kernel) {
+                        multiplyResident<Acc, Layout>(queueAcc, workDivAcc, kernel,
+                            devHost, deviceA.data(), deviceX, deviceY, x, y, BS, NBS, K);
+                    });
+                },
+                clearY));
+            report.add(checkedResult("resident cold", cold));
 
-                alpaka::kernel::exec<Acc>(queueAcc,
-                    workDivAcc,
-                    multMatricVectorKernel,
-                    alpaka::mem::view::getPtrNative(deviceYBlock) + block_r,
-                    alpaka::mem::view::getPtrNative(deviceABlock) + block_r * BS,
-                    alpaka::mem::view::getPtrNative(deviceXBlock),
-                    BS);
+            auto deviceA = pool.template alloc<Storage>(NS * NS);
+            auto deviceX = pool.template alloc<Data>(NS * K);
+            auto deviceY = pool.template alloc<Data>(NS * K);
+#ifndef USE_GPU
+            alpaka::kernel::exec<Acc>(queueAcc, workDivAcc, FirstTouchBlockMatrix<Layout>(),
+                deviceA.data(), N, BS, NBS);
+#endif
+            alpaka::mem::view::copy(queueAcc, deviceA.view(), hostAPlain, NS * NS);
+
+            auto multiply = [&] {
+                withKernel(layoutTag, [&](auto const & kernel) {
+                    multiplyResident<Acc, Layout>(queueAcc, workDivAcc, kernel,
+                        devHost, deviceA.data(), deviceX, deviceY, x, y, BS, NBS, K);
+                });
+            };
+
+            /* a warm run is R products that only move x and y, timed per
+             * product; they add up in y, which is only cleared before the run */
+            auto samples = mephisto::measure(bench,
+                [&] {
+                    for (Size r = 0; r < R; r++) {
+                        multiply();
+                    }
+                },
+                clearY);
+            for (auto & sample : samples) {
+                sample /= R;
             }
+
+            /* one untimed product for the error check */
+            clearY();
+            multiply();
+
+            auto warm = checkedResult("resident warm", mephisto::summarize(samples));
+            warm.bytes = 2.0 * N * K * sizeof(Data);
+            report.add(warm);
         }
+    };
 
-        /* copy y from device back into host memory */
-        alpaka::mem::view::copy(queueAcc, hostYBlockPlain, deviceYBlock, BS);
+    mephisto::with_layout(layout, [&](auto layoutTag) {
+        using Layout = decltype(layoutTag);
 
-#if 0
-        /* validate result */
-        for (Size local_y = 0; local_y < BS; local_y++) {
-            Size global_y = block_y * BS + local_y;
-            Data y_value = (global_y < N) ? (global_y * N * N + ((N * (N - 1)) / 2)) : 0.0;
+        /* the narrow copies keep the layout and the page placement of A */
+        auto multiplyNarrow = [&](auto * tag) {
+            using Storage = typename std::remove_pointer<decltype(tag)>::type;
+            Storage * AS = mephisto::alloc_first_touch<Storage>(NS * NS);
+            initMatrix<AccTouch, Layout>(queueTouch, workDivTouch, AS, N, BS, NBS);
+            multiplyModes(AS, layoutTag);
+            mephisto::free_first_touch(AS, NS * NS);
+        };
 
-            if (alpaka::mem::view::getPtrNative(hostYBlockPlain)[local_y] != y_value)
-                printf("Y[%zu]: %f != %f\n", global_y, alpaka::mem::view::getPtrNative(hostYBlockPlain)[local_y], y_value);
+        if (storage == "float") {
+            multiplyNarrow(static_cast<float *>(nullptr));
+        } else if (storage == "bf16") {
+            multiplyNarrow(static_cast<mephisto::bfloat16 *>(nullptr));
+        } else {
+            multiplyModes(A, layoutTag);
         }
-#endif
-    }
+    });
 
-    // Take the time after the execution.
-    auto const tpEnd(std::chrono::high_resolution_clock::now());
+    std::cout << pool.statistics() << std::endl;
+    report.write();
 
-    auto const durElapsed(tpEnd - tpStart);
-    std::cout << ((double)N * N)/(double)std::chrono::duration_cast<std::chrono::microseconds>(durElapsed).count() << std::endl;
-#endif
-    delete[] A;
-    delete[] x;
-    delete[] y;
+    mephisto::free_first_touch(A, NS * NS);
+    mephisto::free_first_touch(x, NS * K);
+    mephisto::free_first_touch(y, NS * K);
+    /* free device memory before the runtime shuts down at exit */
+    mephisto::release_pools<DevAcc>();
 
-    /**
-     * Everything is fine, so lets return :)
-     */
-    return EXIT_SUCCESS;
+    return report.passed() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -2,22 +2,39 @@
 #include <iostream>
 #include <cstddef>
 #include <iomanip>
-#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include <libdash.h>
 #include <alpaka/alpaka.hpp>
 
+#include <mephisto/algorithm/reduce_scatter>
+#include <mephisto/allocator>
+#include <mephisto/bench>
+#include <mephisto/bfloat16>
+#include <mephisto/buffer>
+#include <mephisto/operator>
+#include <mephisto/pool>
+#include <mephisto/reference>
+#include <mephisto/sparse>
+#include <mephisto/team_bench>
+#include <mephisto/tiles>
+
 struct BlockMultMatrixVector
 {
     template<
         typename TAcc,
         typename TData,
+        typename TStorage,
         typename TSize,
         typename TIndex>
     ALPAKA_FN_ACC auto operator()(
         TAcc const & acc,
         TData * const y,
-        TData * const A,
+        TStorage * const A,
         TData * const x,
         TSize N,
         TIndex beginY,
@@ -33,12 +50,95 @@ struct BlockMultMatrixVector
 
         TData prod = 0.0;
         for (TSize local_x = 0; local_x < N; ++local_x) {
-            prod += A[linearizedGlobalThreadIdx[0u] * N + local_x] * x[beginX + local_x];
+            prod += static_cast<TData>(A[linearizedGlobalThreadIdx[0u] * N + local_x]) * x[beginX + local_x];
+        }
+        y[beginY + linearizedGlobalThreadIdx[0u]] += prod;
+    }
+};
+
+/* y += A^T * x for an M x N block, one thread per column of the block.
+ * Neighbouring threads read neighbouring elements of every row of A. */
+struct BlockMultMatrixTransposedVector
+{
+    template<
+        typename TAcc,
+        typename TData,
+        typename TStorage,
+        typename TSize,
+        typename TIndex>
+    ALPAKA_FN_ACC auto operator()(
+        TAcc const & acc,
+        TData * const y,
+        TStorage * const A,
+        TData * const x,
+        TSize M,
+        TSize N,
+        TIndex beginY,
+        TIndex beginX ) const
+    -> void
+    {
+        auto const globalThreadIdx = alpaka::idx::getIdx<alpaka::Grid, alpaka::Threads>(acc);
+        auto const globalThreadExtent = alpaka::workdiv::getWorkDiv<alpaka::Grid, alpaka::Threads>(acc);
+
+        auto const linearizedGlobalThreadIdx = alpaka::idx::mapIdx<1u>(
+            globalThreadIdx,
+            globalThreadExtent);
+
+        TData prod = 0.0;
+        for (TSize local_y = 0; local_y < M; ++local_y) {
+            prod += static_cast<TData>(A[local_y * N + linearizedGlobalThreadIdx[0u]]) * x[beginX + local_y];
         }
         y[beginY + linearizedGlobalThreadIdx[0u]] += prod;
     }
 };
 
+/* y += A * x for a SELL-C-sigma tile, one thread per slot of a chunk.
+ * The C threads of a chunk read C consecutive elements of A. */
+struct SellMultMatrixVector
+{
+    template<
+        typename TAcc,
+        typename TData,
+        typename TSize>
+    ALPAKA_FN_ACC auto operator()(
+        TAcc const & acc,
+        TData * const y,
+        TData const * const values,
+        TSize const * const col_idx,
+        TData const * const x,
+        TSize const * const chunk_ptr,
+        TSize const * const chunk_len,
+        TSize const * const slot_row,
+        TSize rows,
+        TSize C,
+        TSize beginY,
+        TSize beginX ) const
+    -> void
+    {
+        auto const globalThreadIdx = alpaka::idx::getIdx<alpaka::Grid, alpaka::Threads>(acc);
+        auto const globalThreadExtent = alpaka::workdiv::getWorkDiv<alpaka::Grid, alpaka::Threads>(acc);
+
+        auto const linearizedGlobalThreadIdx = alpaka::idx::mapIdx<1u>(
+            globalThreadIdx,
+            globalThreadExtent);
+
+        TSize const slot = linearizedGlobalThreadIdx[0u];
+        TSize const row = slot_row[slot];
+        if (row >= rows) {
+            return;
+        }
+        TSize const chunk = slot / C;
+        TSize const lane = slot % C;
+
+        TData prod = 0.0;
+        for (TSize j = 0; j < chunk_len[chunk]; ++j) {
+            TSize const idx = chunk_ptr[chunk] + j * C + lane;
+            prod += values[idx] * x[beginX + col_idx[idx]];
+        }
+        y[beginY + row] += prod;
+    }
+};
+
 template<class MatrixT>
 void print_matrix(const MatrixT & matrix)
 {
@@ -89,10 +189,28 @@ template<
   typename         IndexType>
 struct is_dash_tile_pattern<dash::TilePattern<NumDimensions, Arrangement, IndexType>> : std::true_type {};
 
+/* plan of the reduction into y, built once and kept across products */
 template<typename Data>
-void product_tile_pattern(const dash::Matrix<Data,2>& A,
-                          const dash::Array<Data>&    x,
-                          dash::Array<Data>&          y)
+using ReductionPlan = mephisto::ReduceScatterPlan<Data, typename dash::Array<Data>::pattern_type>;
+
+/**
+ * Compute y = A * x, or y = A^T * x if transposed is set. A may be stored
+ * in a narrower type than the vectors, the kernels sum up in Data.
+ *
+ * With batch_tiles the whole local part of A is uploaded at once and
+ * multiplied by a single kernel launch, otherwise every local tile is
+ * uploaded and multiplied on its own. The transposed product swaps the
+ * roles of x and y: x is fetched for the rows and y is reduced for the
+ * columns of the local tiles. It is only available per block. plan is the
+ * plan of the reduction into y.
+ */
+template<typename Storage, typename Data>
+void product_tile_pattern(const dash::Matrix<Storage,2>& A,
+                          const dash::Array<Data>&       x,
+                          dash::Array<Data>&             y,
+                          ReductionPlan<Data>&           plan,
+                          bool                           batch_tiles = false,
+                          bool                           transposed = false)
 {
     if (A.size() <= 1024 && dash::myid() == 0) {
         std::cout << A.pattern().blockspec() << std::endl;
@@ -106,17 +224,27 @@ void product_tile_pattern(const dash::Matrix<Data,2>& A,
                   << " matrix " << std::endl;
     }
     auto& pattern = A.pattern();
-    static_assert(is_dash_tile_pattern<typename dash::Matrix<Data,2>::pattern_type>::value,
+    static_assert(is_dash_tile_pattern<typename dash::Matrix<Storage,2>::pattern_type>::value,
                   "This works only for TilePattern.");
 
-    // local copy of x
-    std::vector<Data> local_x(x.size());
-    dash::copy(x.begin(), x.end(), local_x.data());
-    // local result space for y
-    std::vector<Data> local_y(y.size(), 0.0);
-
     using Size = decltype(A.size());
 
+    /* global column and row ranges touched by the local tiles */
+    auto tiles = mephisto::local_tiles<Size>(A);
+    auto col_intervals = mephisto::column_intervals(tiles);
+    auto row_intervals = mephisto::row_intervals(tiles);
+    DASH_ASSERT(!(batch_tiles && transposed));
+
+    /* ranges of x and y, swapped for the transposed product */
+    auto& x_intervals = transposed ? row_intervals : col_intervals;
+    auto& y_intervals = transposed ? col_intervals : row_intervals;
+
+    // local copy of the needed parts of x
+    auto& local_x = mephisto::workspace<Data>(0, mephisto::compact_size(x_intervals));
+    mephisto::fetch_intervals(x, x_intervals, local_x.data());
+    // local result space for the touched rows of y
+    auto& local_y = mephisto::workspace<Data>(1, mephisto::compact_size(y_intervals), Data(0));
+
     using Dim = alpaka::dim::DimInt<1>;
     using WorkDiv = alpaka::workdiv::WorkDivMembers<Dim, Size>;
 
@@ -141,43 +269,267 @@ void product_tile_pattern(const dash::Matrix<Data,2>& A,
     QueueAcc queue_acc(dev_acc);
 
     BlockMultMatrixVector mult_mxv_kernel;
+    BlockMultMatrixTransposedVector mult_mtxv_kernel;
+
+    /* device buffers are reused across calls through the pool of the device */
+    auto& pool = mephisto::get_pool(dev_acc);
 
     /* vector x and y are the whole time on the device */
 
-    alpaka::mem::buf::Buf<DevAcc, Data, Dim, Size> device_y(alpaka::mem::buf::alloc<Data, Size>(dev_acc, local_y.size()));
+    auto device_y = pool.template alloc<Data>(local_y.size());
     alpaka::mem::view::ViewPlainPtr<DevHost, Data, Dim, Size> local_y_plain(local_y.data(), dev_host, local_y.size());
-    alpaka::mem::view::copy(queue_acc, device_y, local_y_plain, local_y.size());
+    alpaka::mem::view::copy(queue_acc, device_y.view(), local_y_plain, local_y.size());
 
-    alpaka::mem::buf::Buf<DevAcc, Data, Dim, Size> device_x(alpaka::mem::buf::alloc<Data, Size>(dev_acc, local_x.size()));
+    auto device_x = pool.template alloc<Data>(local_x.size());
     alpaka::mem::view::ViewPlainPtr<DevHost, const Data, Dim, Size> local_x_plain(local_x.data(), dev_host, local_x.size());
-    alpaka::mem::view::copy(queue_acc, device_x, local_x_plain, local_x.size());
+    alpaka::mem::view::copy(queue_acc, device_x.view(), local_x_plain, local_x.size());
+
+    if (batch_tiles) {
+        using Tile = mephisto::TileInfo<Size>;
+        using Group = mephisto::TileRowGroup<Size>;
+
+        /* the kernel indexes the compact x and y */
+        tiles = mephisto::compact_tiles(tiles, row_intervals, col_intervals);
+        auto groups = mephisto::tile_row_groups(tiles);
+        Size max_rows = mephisto::max_group_rows(groups);
+
+        /* the local tiles are contiguous from A.lbegin(), upload all at once */
+        Size lsize = A.lend() - A.lbegin();
+        auto device_a = pool.template alloc<Storage>(lsize);
+        alpaka::mem::view::ViewPlainPtr<DevHost, const Storage, Dim, Size> local_a_plain(A.lbegin(), dev_host, lsize);
+        alpaka::mem::view::copy(queue_acc, device_a.view(), local_a_plain, lsize);
+
+        auto device_tiles = pool.template alloc<Tile>(tiles.size());
+        alpaka::mem::view::ViewPlainPtr<DevHost, Tile, Dim, Size> tiles_plain(tiles.data(), dev_host, tiles.size());
+        alpaka::mem::view::copy(queue_acc, device_tiles.view(), tiles_plain, tiles.size());
+
+        auto device_groups = pool.template alloc<Group>(groups.size());
+        alpaka::mem::view::ViewPlainPtr<DevHost, Group, Dim, Size> groups_plain(groups.data(), dev_host, groups.size());
+        alpaka::mem::view::copy(queue_acc, device_groups.view(), groups_plain, groups.size());
+
+        if (!groups.empty()) {
+            WorkDiv const work_div_acc(
+                alpaka::workdiv::getValidWorkDiv<Acc>(
+                    dev_acc,
+                    groups.size() * max_rows,
+                    Size(1u),
+                    false,
+                    alpaka::workdiv::GridBlockExtentSubDivRestrictions::Unrestricted));
+
+            alpaka::kernel::exec<Acc>(
+                queue_acc,
+                work_div_acc,
+                mephisto::BatchMultMatrixVector(),
+                device_y.data(),
+                device_a.data(),
+                device_x.data(),
+                device_tiles.data(),
+                device_groups.data(),
+                Size(groups.size()),
+                max_rows);
+        }
+    } else {
+        /* We need at most max_blocksize() elements on the device per block */
+        auto device_a_block = pool.template alloc<Storage>(pattern.max_blocksize());
+
+        auto lblocks = pattern.local_blockspec().size();
+        for (size_t lblock_idx = 0; lblock_idx < lblocks; lblock_idx++ ) {
+            auto lblock_view = pattern.local_block_local(lblock_idx);
+            auto local_index = pattern.local_at({0,0}, lblock_view);
+
+            auto global_index = pattern.global(local_index);
+            auto global_coords = pattern.coords(global_index);
+            //std::cout << dash::myid() << ": " << lblock_idx << " -> " << lblock_view << " : {0,0} -> " << local_index << " -> " << global_index << " -> {" << global_coords[0] << "," << global_coords[1] << "}" << std::endl;
+
+            /* begin of the local block */
+            auto *lblock_begin = A.lbegin() + local_index;
+
+            Size M = lblock_view.extent(0);
+            Size N = lblock_view.extent(1);
+
+            /* copy A from host memory to device */
+            alpaka::mem::view::ViewPlainPtr<DevHost, const Storage, Dim, Size> lblock_plain(lblock_begin, dev_host, M * N);
+            alpaka::mem::view::copy(queue_acc, device_a_block.view(), lblock_plain, M * N);
+
+            Size begin_row = mephisto::compact_index(row_intervals, Size(global_coords[0]));
+            Size begin_col = mephisto::compact_index(col_intervals, Size(global_coords[1]));
+
+            /* one thread per row of y, i.e. per column of A if transposed */
+            WorkDiv const work_div_acc(
+                alpaka::workdiv::getValidWorkDiv<Acc>(
+                    dev_acc,
+                    transposed ? N : M,
+                    Size(1u),
+                    false,
+                    alpaka::workdiv::GridBlockExtentSubDivRestrictions::Unrestricted));
+
+            if (transposed) {
+                alpaka::kernel::exec<Acc>(
+                    queue_acc,
+                    work_div_acc,
+                    mult_mtxv_kernel,
+                    device_y.data(),
+                    device_a_block.data(),
+                    device_x.data(),
+                    M,
+                    N,
+                    begin_col,
+                    begin_row);
+            } else {
+                alpaka::kernel::exec<Acc>(
+                    queue_acc,
+                    work_div_acc,
+                    mult_mxv_kernel,
+                    device_y.data(),
+                    device_a_block.data(),
+                    device_x.data(),
+                    N,
+                    begin_row,
+                    begin_col);
+            }
+        }
+    }
 
-    /* We need at most max_blocksize() elements on the device per block */
-    alpaka::mem::buf::Buf<DevAcc, Data, Dim, Size> device_a_block(alpaka::mem::buf::alloc<Data, Size>(dev_acc, pattern.max_blocksize()));
+    /* copy y from device back into host memory */
+    alpaka::mem::view::copy(queue_acc, local_y_plain, device_y.view(), local_y.size());
 
-    auto lblocks = pattern.local_blockspec().size();
-    for (size_t lblock_idx = 0; lblock_idx < lblocks; lblock_idx++ ) {
-        auto lblock_view = pattern.local_block_local(lblock_idx);
-        auto local_index = pattern.local_at({0,0}, lblock_view);
+    /* reduce local result vectors into global y vector */
+    if (A.size() <= 1024) {
+        std::cout << dash::myid() << ": local Vector y size: " << local_y.size() << std::endl;
+        print_vector(local_y);
+    }
 
-        auto global_index = pattern.global(local_index);
-        auto global_coords = pattern.coords(global_index);
-        //std::cout << dash::myid() << ": " << lblock_idx << " -> " << lblock_view << " : {0,0} -> " << local_index << " -> " << global_index << " -> {" << global_coords[0] << "," << global_coords[1] << "}" << std::endl;
+    /* every unit receives the sums of the segment of y it owns */
+    mephisto::reduce_scatter(plan, local_y.data(), y_intervals, y);
+}
 
-        /* begin of the local block */
-        auto *lblock_begin = A.lbegin() + local_index;
+/* rows per chunk of the SELL-C-sigma tiles: a warp on the GPU, a few
+ * vector lanes on the CPU, and the window the rows are sorted in */
+#ifdef USE_GPU
+constexpr std::size_t SellChunkHeight = 32;
+#else
+constexpr std::size_t SellChunkHeight = 8;
+#endif
+constexpr std::size_t SellSortWindow = 8 * SellChunkHeight;
 
-        Size M = lblock_view.extent(0);
-        Size N = lblock_view.extent(1);
+/**
+ * The local tiles of a sparse matrix that hold nonzeros, converted to
+ * SELL-C-sigma, in the same order as their tile table.
+ */
+template<typename Data>
+struct SellTiles
+{
+    using Size = typename mephisto::SparseTileMatrix<Data>::size_type;
 
-        /* copy A from host memory to device */
-        alpaka::mem::view::ViewPlainPtr<DevHost, const Data, Dim, Size> lblock_plain(lblock_begin, dev_host, M * N);
-        alpaka::mem::view::copy(queue_acc, device_a_block, lblock_plain, M * N);
+    std::vector<mephisto::TileInfo<Size>>       tiles;
+    std::vector<mephisto::SellTile<Data, Size>> sell;
+};
+
+template<typename Data>
+SellTiles<Data> sell_tiles(const mephisto::SparseTileMatrix<Data>& A)
+{
+    using Size = typename SellTiles<Data>::Size;
+
+    SellTiles<Data> result;
+    for (auto& tile : A.tiles()) {
+        if (A.tile(tile.offset).nnz() > 0) {
+            result.tiles.push_back(tile);
+            result.sell.push_back(mephisto::to_sell(A.tile(tile.offset), Size(SellChunkHeight), Size(SellSortWindow)));
+        }
+    }
+    return result;
+}
+
+/**
+ * Compute y = A * x for a sparse matrix whose local tiles have been
+ * converted to SELL-C-sigma with sell_tiles.
+ *
+ * The tiles are multiplied one at a time like in the per-block product.
+ * Tiles without nonzeros are skipped, so their parts of x are not fetched
+ * and they add no partial sums. All units still take part in the
+ * reduction into y, see ReduceScatterPlan.
+ */
+template<typename Data>
+void product_sparse_tile_pattern(const SellTiles<Data>&   A,
+                                 const dash::Array<Data>& x,
+                                 dash::Array<Data>&       y,
+                                 ReductionPlan<Data>&     plan)
+{
+    using Size = typename SellTiles<Data>::Size;
+
+    auto& tiles = A.tiles;
+    auto col_intervals = mephisto::column_intervals(tiles);
+    auto row_intervals = mephisto::row_intervals(tiles);
+
+    auto& local_x = mephisto::workspace<Data>(0, mephisto::compact_size(col_intervals));
+    mephisto::fetch_intervals(x, col_intervals, local_x.data());
+    auto& local_y = mephisto::workspace<Data>(1, mephisto::compact_size(row_intervals), Data(0));
+
+    using Dim = alpaka::dim::DimInt<1>;
+    using WorkDiv = alpaka::workdiv::WorkDivMembers<Dim, Size>;
+
+    using Host = alpaka::acc::AccCpuSerial<Dim, Size>;
+    using DevHost = alpaka::dev::Dev<Host>;
+    using PltfHost = alpaka::pltf::Pltf<DevHost>;
+
+#ifdef USE_GPU
+    using Acc = alpaka::acc::AccGpuCudaRt<Dim, Size>;
+    using QueueAcc = alpaka::queue::QueueCudaRtSync;
+#else
+    using Acc = alpaka::acc::AccCpuOmp2Blocks<Dim, Size>;
+    using QueueAcc = alpaka::queue::QueueCpuSync;
+#endif
+    using DevAcc = alpaka::dev::Dev<Acc>;
+    using PltfAcc = alpaka::pltf::Pltf<DevAcc>;
+
+    DevHost const dev_host(alpaka::pltf::getDevByIdx<PltfHost>(0u));
+    DevAcc const dev_acc(alpaka::pltf::getDevByIdx<PltfAcc>(0u));
+
+    QueueAcc queue_acc(dev_acc);
+    auto& pool = mephisto::get_pool(dev_acc);
+
+    auto device_y = pool.template alloc<Data>(local_y.size());
+    alpaka::mem::view::ViewPlainPtr<DevHost, Data, Dim, Size> local_y_plain(local_y.data(), dev_host, local_y.size());
+    alpaka::mem::view::copy(queue_acc, device_y.view(), local_y_plain, local_y.size());
+
+    auto device_x = pool.template alloc<Data>(local_x.size());
+    alpaka::mem::view::ViewPlainPtr<DevHost, const Data, Dim, Size> local_x_plain(local_x.data(), dev_host, local_x.size());
+    alpaka::mem::view::copy(queue_acc, device_x.view(), local_x_plain, local_x.size());
+
+    Size max_elements = 0;
+    Size max_chunks = 0;
+    for (auto& tile : A.sell) {
+        max_elements = std::max<Size>(max_elements, tile.values.size());
+        max_chunks = std::max<Size>(max_chunks, tile.num_chunks());
+    }
+
+    /* device buffers for the largest tile, reused by all tiles */
+    auto device_values = pool.template alloc<Data>(max_elements);
+    auto device_col_idx = pool.template alloc<Size>(max_elements);
+    auto device_chunk_ptr = pool.template alloc<Size>(max_chunks + 1);
+    auto device_chunk_len = pool.template alloc<Size>(max_chunks);
+    auto device_slot_row = pool.template alloc<Size>(max_chunks * SellChunkHeight);
+
+    for (auto& tile : A.sell) {
+        Size nelem = tile.values.size();
+        Size nchunks = tile.num_chunks();
+        Size nslots = nchunks * tile.chunk_height;
+
+        alpaka::mem::view::ViewPlainPtr<DevHost, const Data, Dim, Size> values_plain(tile.values.data(), dev_host, nelem);
+        alpaka::mem::view::copy(queue_acc, device_values.view(), values_plain, nelem);
+        alpaka::mem::view::ViewPlainPtr<DevHost, const Size, Dim, Size> col_idx_plain(tile.col_idx.data(), dev_host, nelem);
+        alpaka::mem::view::copy(queue_acc, device_col_idx.view(), col_idx_plain, nelem);
+        alpaka::mem::view::ViewPlainPtr<DevHost, const Size, Dim, Size> chunk_ptr_plain(tile.chunk_ptr.data(), dev_host, nchunks + 1);
+        alpaka::mem::view::copy(queue_acc, device_chunk_ptr.view(), chunk_ptr_plain, nchunks + 1);
+        alpaka::mem::view::ViewPlainPtr<DevHost, const Size, Dim, Size> chunk_len_plain(tile.chunk_len.data(), dev_host, nchunks);
+        alpaka::mem::view::copy(queue_acc, device_chunk_len.view(), chunk_len_plain, nchunks);
+        alpaka::mem::view::ViewPlainPtr<DevHost, const Size, Dim, Size> slot_row_plain(tile.slot_row.data(), dev_host, nslots);
+        alpaka::mem::view::copy(queue_acc, device_slot_row.view(), slot_row_plain, nslots);
 
         WorkDiv const work_div_acc(
             alpaka::workdiv::getValidWorkDiv<Acc>(
                 dev_acc,
-                M,
+                nslots,
                 Size(1u),
                 false,
                 alpaka::workdiv::GridBlockExtentSubDivRestrictions::Unrestricted));
@@ -185,52 +537,121 @@ void product_tile_pattern(const dash::Matrix<Data,2>& A,
         alpaka::kernel::exec<Acc>(
             queue_acc,
             work_div_acc,
-            mult_mxv_kernel,
-            alpaka::mem::view::getPtrNative(device_y),
-            alpaka::mem::view::getPtrNative(device_a_block),
-            alpaka::mem::view::getPtrNative(device_x),
-            M, global_coords[0], global_coords[1]);
+            SellMultMatrixVector(),
+            device_y.data(),
+            device_values.data(),
+            device_col_idx.data(),
+            device_x.data(),
+            device_chunk_ptr.data(),
+            device_chunk_len.data(),
+            device_slot_row.data(),
+            tile.rows,
+            tile.chunk_height,
+            mephisto::compact_index(row_intervals, tile.row),
+            mephisto::compact_index(col_intervals, tile.col));
     }
 
     /* copy y from device back into host memory */
-    alpaka::mem::view::copy(queue_acc, local_y_plain, device_y, local_y.size());
+    alpaka::mem::view::copy(queue_acc, local_y_plain, device_y.view(), local_y.size());
 
-    /* reduce local result vectors into global y vector */
-    if (A.size() <= 1024) {
-        std::cout << dash::myid() << ": local Vector y size: " << local_y.size() << std::endl;
-        print_vector(local_y);
-    }
+    mephisto::reduce_scatter(plan, local_y.data(), row_intervals, y);
+}
+
+/**
+ * Time y = A * x with a device resident operator.
+ *
+ * A cold run creates the operator, which uploads A, and applies it once.
+ * A warm run applies an existing operator repetitions times and only
+ * moves x and y, its timings are per product.
+ */
+template<typename Data>
+void benchmark_operator(const dash::Matrix<Data,2>& A,
+                        const dash::Array<Data>&    x,
+                        dash::Array<Data>&          y,
+                        int                         repetitions,
+                        mephisto::BenchReport&      report)
+{
+    using Size = decltype(A.size());
+
+    using Dim = alpaka::dim::DimInt<1>;
+
+    using Host = alpaka::acc::AccCpuSerial<Dim, Size>;
+    using DevHost = alpaka::dev::Dev<Host>;
+    using PltfHost = alpaka::pltf::Pltf<DevHost>;
+
+#ifdef USE_GPU
+    using Acc = alpaka::acc::AccGpuCudaRt<Dim, Size>;
+    using QueueAcc = alpaka::queue::QueueCudaRtSync;
+#else
+    using Acc = alpaka::acc::AccCpuOmp2Blocks<Dim, Size>;
+    using QueueAcc = alpaka::queue::QueueCpuSync;
+#endif
+    using DevAcc = alpaka::dev::Dev<Acc>;
+    using PltfAcc = alpaka::pltf::Pltf<DevAcc>;
+
+    DevHost const dev_host(alpaka::pltf::getDevByIdx<PltfHost>(0u));
+    DevAcc const dev_acc(alpaka::pltf::getDevByIdx<PltfAcc>(0u));
+
+    QueueAcc queue_acc(dev_acc);
+    auto ctx = mephisto::make_ctx(dev_host, dev_acc);
 
+    auto cold = mephisto::time_collective(report.config(), dash::Team::All(), [&] {
+        auto op = mephisto::make_operator<Acc>(ctx, queue_acc, A, y);
+        op.apply(x, y);
+    });
+
+    mephisto::BenchResult result = mephisto::dense_result("operator cold", A.extent(0), A.extent(1), 1, "double", cold);
+    result.error = mephisto::reference_error(A, x, y);
+    result.tolerance = mephisto::product_tolerance<double>(A.extent(1));
+    report.add(result);
+
+    auto op = mephisto::make_operator<Acc>(ctx, queue_acc, A, y);
     auto& team = y.team();
-    auto team_size = team.size();
-    team.barrier();
-
-    dash::NArray<Data,2> result_matrix(
-        dash::SizeSpec<2>(
-            y.size(),
-            team_size),
-       dash::DistributionSpec<2>{},
-        team);
-    auto& result_pattern = result_matrix.pattern();
-
-    auto myid = team.myid();
-    for (decltype(local_y.size()) i = 0; i < local_y.size(); ++i) {
-        result_matrix[i][myid] = local_y[i];
+    auto samples = mephisto::measure(report.config(),
+                                     [&] {
+                                         for (int r = 0; r < repetitions; ++r) {
+                                             op.apply(x, y);
+                                         }
+                                         team.barrier();
+                                     },
+                                     [&] { team.barrier(); });
+    for (auto& sample : samples) {
+        sample /= repetitions;
     }
-    team.barrier();
 
-    for (auto r = 0; r < y.size(); ++r) {
-        const auto& coord = result_pattern.local({r,0});
-        if (coord.unit != myid)
-            continue;
+    result = mephisto::dense_result("operator warm", A.extent(0), A.extent(1), 1, "double", mephisto::summarize(samples));
+    /* A stays on the device, only x and y are moved */
+    result.bytes = (A.extent(0) + A.extent(1)) * sizeof(Data);
+    result.error = mephisto::reference_error(A, x, y);
+    result.tolerance = mephisto::product_tolerance<double>(A.extent(1));
+    report.add(result);
+}
 
-        Data sum = (Data)0;
-        for (decltype(team_size) c = 0; c < team_size; ++c) {
-            sum += result_matrix.local[coord.coords[0]][c];
-        }
-        y[r] = sum;
-    }
-    team.barrier();
+/**
+ * Print the usage of the memory pool of the accelerator the products ran
+ * on, on every unit.
+ */
+void print_device_pool()
+{
+#ifdef USE_GPU
+    using DevAcc = alpaka::dev::DevCudaRt;
+#else
+    using DevAcc = alpaka::dev::DevCpu;
+#endif
+    DevAcc const dev_acc(alpaka::pltf::getDevByIdx<alpaka::pltf::Pltf<DevAcc>>(0u));
+    std::cout << dash::myid() << ": " << mephisto::get_pool(dev_acc).statistics() << std::endl;
+}
+
+/**
+ * Free the memory pools of the devices the products ran on, before the
+ * device runtime shuts down at exit.
+ */
+void release_device_pools()
+{
+#ifdef USE_GPU
+    mephisto::release_pools<alpaka::dev::DevCudaRt>();
+#endif
+    mephisto::release_pools<alpaka::dev::DevCpu>();
 }
 
 int main(int argc, char* argv[])
@@ -253,10 +674,138 @@ int main(int argc, char* argv[])
         std::istringstream in(argv[2]);
         in >> tile_size;
     }
+    /* per-block or batched upload of the local tiles, a resident operator,
+     * the per-block product with the transpose of the matrix (transposed),
+     * or a sparse matrix stored in SELL-C-sigma tiles (sparse) */
+    std::string mode = "per-block";
+    if (argc > 3) {
+        mode = argv[3];
+    }
+    /* number of products per warm run in operator mode */
+    int repetitions = 10;
+    if (argc > 4) {
+        std::istringstream in(argv[4]);
+        if (!(in >> repetitions) || !in.eof() || repetitions <= 0) {
+            if (0 == myid) {
+                std::cerr << "invalid number of products per warm run " << argv[4] << std::endl;
+            }
+            dash::finalize();
+            return EXIT_FAILURE;
+        }
+    }
+    /* storage type of the matrix: double, float or bf16 */
+    std::string storage = "double";
+    if (argc > 5) {
+        storage = argv[5];
+    }
+    /* allocation of host buffers, pages[:alignment] with pages default,
+     * thp or huge */
+    if (argc > 6) {
+        try {
+            mephisto::default_allocation_policy() = mephisto::parse_allocation_policy(argv[6]);
+        } catch (std::runtime_error& e) {
+            if (0 == myid) {
+                std::cerr << e.what() << std::endl;
+            }
+            dash::finalize();
+            return EXIT_FAILURE;
+        }
+    }
+    /* reporting of the timings, format[:warmup[:repetitions[:file]]] with
+     * format text, csv or json, followed by +stream to compare the results
+     * with the STREAM triad bandwidth */
+    mephisto::BenchConfig bench;
+    if (argc > 7) {
+        try {
+            bench = mephisto::parse_bench_config(argv[7]);
+        } catch (std::runtime_error& e) {
+            if (0 == myid) {
+                std::cerr << e.what() << std::endl;
+            }
+            dash::finalize();
+            return EXIT_FAILURE;
+        }
+    }
+    if (mode != "per-block" && mode != "batched" && mode != "operator"
+     && mode != "transposed" && mode != "sparse") {
+        if (0 == myid) {
+            std::cerr << "unknown mode " << mode << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
+    if (storage != "double" && storage != "float" && storage != "bf16") {
+        if (0 == myid) {
+            std::cerr << "unknown storage type " << storage << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
+    if (storage != "double" && (mode == "operator" || mode == "sparse")) {
+        if (0 == myid) {
+            std::cerr << "storage type " << storage
+                      << " is not supported in " << mode << " mode" << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
     size_t rows = tile_size * teamspec_2d.num_units(0) * size_factor;
     size_t cols = tile_size * teamspec_2d.num_units(1) * size_factor;
     size_t matrix_size = rows * cols;
 
+    /* the STREAM ceiling is only measured on request, it takes a while */
+    double ceiling = bench.stream ? mephisto::stream_ceiling(dash::Team::All()) : 0.0;
+    mephisto::BenchReport report("dash-alpaka-mxv", bench, ceiling);
+
+    if (mode == "sparse") {
+        /* tridiagonal second difference operator, the dense matrix is never allocated */
+        dash::TilePattern<2> pattern(dash::SizeSpec<2>(rows, cols),
+                                     dash::DistributionSpec<2>(
+                                       dash::TILE(tile_size),
+                                       dash::TILE(tile_size)),
+                                     teamspec_2d,
+                                     dash::Team::All());
+        mephisto::SparseTileMatrix<double> sparse(pattern, [](size_t r, size_t begin, size_t end, auto emit) {
+            /* columns r - 1, r and r + 1 that fall into [begin, end) */
+            for (size_t c = std::max(begin, r > 0 ? r - 1 : 0); c < std::min(end, r + 2); ++c) {
+                emit(c, r == c ? 2.0 : -1.0);
+            }
+        });
+
+        dash::Array<double> vector_x(cols);
+        dash::Array<double> vector_y(rows);
+        std::fill(vector_x.lbegin(), vector_x.lend(), (double)myid);
+
+        size_t local_nnz = sparse.local_nnz();
+        size_t nnz = 0;
+        dart_allreduce(&local_nnz, &nnz, 1,
+                       dash::dart_datatype<size_t>::value,
+                       DART_OP_SUM,
+                       dash::Team::All().dart_id());
+
+        /* the conversion to SELL-C-sigma is done once, outside the timing */
+        auto sell = sell_tiles(sparse);
+        ReductionPlan<double> plan(vector_y.pattern());
+        auto stats = mephisto::time_collective(bench, dash::Team::All(), [&] {
+            product_sparse_tile_pattern(sell, vector_x, vector_y, plan);
+        });
+
+        /* every nonzero is read with its column index */
+        mephisto::BenchResult result = mephisto::dense_result(mode, rows, cols, 1, "double", stats);
+        result.flops = 2.0 * nnz;
+        result.bytes = nnz * (sizeof(double) + sizeof(size_t)) + (rows + cols) * sizeof(double);
+        result.error = mephisto::reference_error(sparse, vector_x, vector_y);
+        result.tolerance = mephisto::product_tolerance<double>(cols);
+        report.add(result);
+
+        if (0 == myid) {
+            report.write();
+        }
+        release_device_pools();
+        dash::finalize();
+        return report.passed() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     if (matrix_size <= 1024 && 0 == myid) {
         std::cout << "Matrix size: " << rows
                   << " x " << cols
@@ -277,15 +826,27 @@ int main(int argc, char* argv[])
     DASH_ASSERT(rows == matrix.extent(0));
     DASH_ASSERT(cols == matrix.extent(1));
 
-    dash::Array<double> vector_x(cols);
-    dash::Array<double> vector_y(rows);
+    /* A^T * x maps vectors of length rows to vectors of length cols */
+    bool transposed = mode == "transposed";
+    dash::Array<double> vector_x(transposed ? rows : cols);
+    dash::Array<double> vector_y(transposed ? cols : rows);
 
     dash::Team::All().barrier();
 
-    std::fill(matrix.lbegin(), matrix.lend(), (double)myid);
+    if (storage == "double") {
+        std::fill(matrix.lbegin(), matrix.lend(), (double)myid);
+    } else {
+        /* values that are not exact in the narrow types */
+        for (size_t i = 0; i < matrix.local_size(); ++i) {
+            matrix.lbegin()[i] = myid + (i % 7) / 7.0;
+        }
+    }
     std::fill(vector_x.lbegin(), vector_x.lend(), (double)myid);
     std::fill(vector_y.lbegin(), vector_y.lend(), 0.0);
 
+    /* the plan of the reduction into y is built once for all products */
+    ReductionPlan<double> plan(vector_y.pattern());
+
     dash::Team::All().barrier();
     if (matrix_size <= 1024 && 0 == myid) {
         print_matrix(matrix);
@@ -294,27 +855,43 @@ int main(int argc, char* argv[])
         print_vector(vector_x);
     }
 
-    auto const tpStart(std::chrono::high_resolution_clock::now());
-    dash::Team::All().barrier();
-
-    product_tile_pattern(matrix, vector_x, vector_y);
-
-    dash::Team::All().barrier();
-    auto const tpEnd(std::chrono::high_resolution_clock::now());
-
-    auto const durElapsed(tpEnd - tpStart);
-    if (0 == myid) {
-        std::cout << matrix_size << " " << std::chrono::duration_cast<std::chrono::microseconds>(durElapsed).count() << std::endl;
+    if (storage == "float") {
+        mephisto::benchmark_storage<float>(report, mode, storage, matrix, vector_x, vector_y,
+            [&](auto& A) { product_tile_pattern(A, vector_x, vector_y, plan, mode == "batched", transposed); },
+            transposed);
+    } else if (storage == "bf16") {
+        mephisto::benchmark_storage<mephisto::bfloat16>(report, mode, storage, matrix, vector_x, vector_y,
+            [&](auto& A) { product_tile_pattern(A, vector_x, vector_y, plan, mode == "batched", transposed); },
+            transposed);
+    } else if (mode == "operator") {
+        benchmark_operator(matrix, vector_x, vector_y, repetitions, report);
+    } else {
+        auto stats = mephisto::time_collective(bench, dash::Team::All(), [&] {
+            product_tile_pattern(matrix, vector_x, vector_y, plan, mode == "batched", transposed);
+        });
+
+        mephisto::BenchResult result = mephisto::dense_result(mode, rows, cols, 1, storage, stats);
+        result.error = mephisto::reference_error(matrix, vector_x, vector_y, 1, transposed);
+        result.tolerance = mephisto::product_tolerance<double>(transposed ? rows : cols);
+        report.add(result);
     }
 
     if (matrix_size <= 1024 && 0 == myid) {
         std::cout << "Vector y size: " << vector_y.size() << std::endl;
         print_vector(vector_y);
     }
+    if (matrix_size <= 1024) {
+        print_device_pool();
+    }
+
+    if (0 == myid) {
+        report.write();
+    }
 
     dash::Team::All().barrier();
 
+    release_device_pools();
     dash::finalize();
 
-    return 0;
+    return report.passed() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
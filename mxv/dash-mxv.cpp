@@ -2,10 +2,31 @@
 #include <iostream>
 #include <cstddef>
 #include <iomanip>
-#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
 
 #include <libdash.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <mephisto/algorithm/reduce_scatter>
+#include <mephisto/allocator>
+#include <mephisto/bench>
+#include <mephisto/bfloat16>
+#include <mephisto/gemv>
+#include <mephisto/io>
+#include <mephisto/reference>
+#include <mephisto/sparse>
+#include <mephisto/symmetric>
+#include <mephisto/team_bench>
+#include <mephisto/tiles>
+
 #if defined(HAVE_MKL_CBLAS)
 #include <mkl_cblas.h>
 #elif defined(HAVE_CBLAS)
@@ -55,40 +76,101 @@ void print_vector(const VectorT & vector)
 
 
 
+/* y += A * x for a row-major M x N tile */
 template<typename T>
-void product(T* y, const T* A, const T* x, int M, int N)
+void product(T* y, const T* A, const T* x, size_t M, size_t N)
 {
-    for (int m = 0; m < M; m++) {
-        T sum = (T)0;
-        for (int n = 0; n < N; n++) {
-            sum += A[m * N + n] * x[n];
-        }
-        y[m] += sum;
-    }
+    mephisto::gemv(y, A, x, M, N);
 }
 
-#if defined(HAVE_CBLAS) || defined(MKL_HAVE_CBLAS)
+#if defined(HAVE_CBLAS) || defined(HAVE_MKL_CBLAS)
 template<>
-void product<double>(double* y, const double* A, const double* x, int M, int N)
+void product<double>(double* y, const double* A, const double* x, size_t M, size_t N)
 {
     cblas_dgemv(CblasRowMajor, CblasNoTrans,
                 M, N,
-                1.0, A, M,
+                1.0, A, N,
                 x, 1, 1.0,
                 y, 1);
 }
 
 template<>
-void product<float>(float* y, const float* A, const float* x, int M, int N)
+void product<float>(float* y, const float* A, const float* x, size_t M, size_t N)
 {
     cblas_sgemv(CblasRowMajor, CblasNoTrans,
                 M, N,
-                1.0, A, M,
+                1.0, A, N,
                 x, 1, 1.0,
                 y, 1);
 }
 #endif
 
+/* y += A^T * x for a row-major M x N tile */
+template<typename T>
+void product_t(T* y, const T* A, const T* x, size_t M, size_t N)
+{
+    mephisto::gemv_t(y, A, x, M, N);
+}
+
+#if defined(HAVE_CBLAS) || defined(HAVE_MKL_CBLAS)
+template<>
+void product_t<double>(double* y, const double* A, const double* x, size_t M, size_t N)
+{
+    cblas_dgemv(CblasRowMajor, CblasTrans,
+                M, N,
+                1.0, A, N,
+                x, 1, 1.0,
+                y, 1);
+}
+
+template<>
+void product_t<float>(float* y, const float* A, const float* x, size_t M, size_t N)
+{
+    cblas_sgemv(CblasRowMajor, CblasTrans,
+                M, N,
+                1.0, A, N,
+                x, 1, 1.0,
+                y, 1);
+}
+#endif
+
+/**
+ * The product kernel for tiles with N columns. BLAS is used if available,
+ * otherwise the built-in kernel unrolled for N if N is a common tile width.
+ */
+template<typename T>
+mephisto::GemvKernel<T> select_product(size_t N)
+{
+#if defined(HAVE_CBLAS) || defined(HAVE_MKL_CBLAS)
+    return &product<T>;
+#else
+    return mephisto::select_gemv<T>(N);
+#endif
+}
+
+/**
+ * The product kernel for tiles with N columns stored as Storage and
+ * vectors of T. Tiles stored in a narrower type are widened to T on the
+ * fly, so the sums are always computed in T.
+ */
+template<typename T, typename Storage>
+struct ProductKernel
+{
+    static mephisto::GemvKernel<T, Storage> select(size_t)
+    {
+        return &mephisto::gemv_mixed<T, Storage>;
+    }
+};
+
+template<typename T>
+struct ProductKernel<T, T>
+{
+    static mephisto::GemvKernel<T> select(size_t N)
+    {
+        return select_product<T>(N);
+    }
+};
+
 template<typename>
 struct is_tile_pattern : std::false_type {};
 
@@ -98,10 +180,134 @@ template<
   typename         IndexType>
 struct is_tile_pattern<dash::TilePattern<NumDimensions, Arrangement, IndexType>> : std::true_type {};
 
+/**
+ * Global row ranges of all tiles that belong to the process row of the
+ * calling unit, whether the unit holds tiles in them or not.
+ */
+template<typename Size, typename PatternT>
+std::vector<mephisto::IndexInterval<Size>> process_row_intervals(const PatternT& pattern)
+{
+    using Index = typename PatternT::index_type;
+
+    auto& teamspec = pattern.teamspec();
+    auto grid_row = teamspec.coords(pattern.team().myid())[0];
+
+    std::vector<mephisto::IndexInterval<Size>> intervals;
+    Size rows = pattern.extent(0);
+    Size block_rows = pattern.blocksize(0);
+    Size offset = 0;
+    for (Size row = 0; row < rows; row += block_rows) {
+        auto unit = pattern.unit_at({static_cast<Index>(row), 0});
+        if (teamspec.coords(unit)[0] != grid_row)
+            continue;
+
+        Size end = std::min(row + block_rows, rows);
+        if (!intervals.empty() && intervals.back().end == row) {
+            intervals.back().end = end;
+        } else {
+            intervals.push_back(mephisto::IndexInterval<Size>{row, end, offset});
+        }
+        offset += end - row;
+    }
+    return intervals;
+}
+
+/**
+ * Threads used for the tile loop of a unit and how they are bound to the
+ * cores: "none" leaves the binding to the OpenMP runtime (OMP_PROC_BIND,
+ * OMP_PLACES), "close" or "spread" request that binding policy.
+ */
+struct ThreadConfig
+{
+    int         threads  = 1;
+    std::string affinity = "none";
+};
+
+/**
+ * Call f(i) for all i in [0, n) on the threads of the configuration.
+ * Without OpenMP the loop runs serially.
+ */
+template<typename Size, typename Func>
+void parallel_for(Size n, const ThreadConfig& threading, Func f)
+{
+    long const count = n;
+#ifdef _OPENMP
+    if (threading.affinity == "close") {
+#pragma omp parallel for schedule(dynamic) num_threads(threading.threads) proc_bind(close)
+        for (long i = 0; i < count; ++i) {
+            f(i);
+        }
+    } else if (threading.affinity == "spread") {
+#pragma omp parallel for schedule(dynamic) num_threads(threading.threads) proc_bind(spread)
+        for (long i = 0; i < count; ++i) {
+            f(i);
+        }
+    } else {
+#pragma omp parallel for schedule(dynamic) num_threads(threading.threads)
+        for (long i = 0; i < count; ++i) {
+            f(i);
+        }
+    }
+#else
+    for (long i = 0; i < count; ++i) {
+        f(i);
+    }
+#endif
+}
+
+/* number of right-hand sides of a vector or a block of vectors */
+template<typename Data>
+size_t rhs_count(const dash::Array<Data>&)
+{
+    return 1;
+}
+
 template<typename Data>
-void product_tile_pattern(const dash::Matrix<Data,2>& A,
-                          const dash::Array<Data>&    x,
-                          dash::Array<Data>&          y)
+size_t rhs_count(const dash::Matrix<Data,2>& X)
+{
+    return X.extent(1);
+}
+
+/**
+ * The reduction of the partial results of the products into y, kept
+ * across products: the plan of the reduction over all units and the
+ * buffers of the reduction within a process row.
+ */
+template<typename VectorT>
+struct Reduction
+{
+    using Data = typename VectorT::value_type;
+
+    explicit Reduction(const VectorT& y)
+      : plan(y.pattern())
+    { }
+
+    mephisto::ReduceScatterPlan<Data, typename VectorT::pattern_type> plan;
+    mephisto::SubTeamBuffers<Data>                                   row_buffers;
+};
+
+/**
+ * Compute y = A * x.
+ *
+ * x and y are either vectors or blocks of k vectors stored as the columns
+ * of a matrix with k columns, whose rows are not split across units. For
+ * blocks, every tile of A is read once for all k vectors. A may be stored
+ * in a narrower type than the vectors, the sums are computed in the type
+ * of the vectors.
+ *
+ * If row_team is a sub-team of the team of y holding the units of one
+ * process row, y is only reduced within the process row. Otherwise the
+ * partial results of all units are reduced together, with the plan or
+ * the buffers of reduction. The local tiles are multiplied by the threads
+ * of the configuration, one tile row at a time.
+ */
+template<typename Storage, typename VectorT>
+void product_tile_pattern(const dash::Matrix<Storage,2>& A,
+                          const VectorT&                 x,
+                          VectorT&                       y,
+                          Reduction<VectorT>&            reduction,
+                          dash::Team&                    row_team = dash::Team::All(),
+                          const ThreadConfig&            threading = ThreadConfig())
 {
     if (A.size() <= 1024 && dash::myid() == 0) {
         std::cout << A.pattern().blockspec() << std::endl;
@@ -114,38 +320,58 @@ void product_tile_pattern(const dash::Matrix<Data,2>& A,
                   << " (" << A.local.extent(0) << " x " << A.local.extent(1) << ")"
                   << " matrix " << std::endl;
     }
-    auto& pattern = A.pattern();
-    static_assert(is_tile_pattern<typename dash::Matrix<Data,2>::pattern_type>::value,
+    static_assert(is_tile_pattern<typename dash::Matrix<Storage,2>::pattern_type>::value,
                   "This works only for TilePattern.");
 
-    // local copy of x
-    std::vector<Data> local_x(x.size());
-    dash::copy(x.begin(), x.end(), local_x.data());
-    // local result space for y
-    std::vector<Data> local_y(y.size(), 0.0);
+    using Size = decltype(A.size());
+    using Data = typename VectorT::value_type;
+
+    /* global column and row ranges touched by the local tiles */
+    auto tiles = mephisto::local_tiles<Size>(A);
+    auto col_intervals = mephisto::column_intervals(tiles);
+    bool grid = row_team.size() < y.team().size();
+    auto row_intervals = grid ? process_row_intervals<Size>(A.pattern())
+                              : mephisto::row_intervals(tiles);
 
-    auto lblocks = pattern.local_blockspec().size();
-    for (size_t lblock_idx = 0; lblock_idx < lblocks; lblock_idx++ ) {
-        auto lblock_view = pattern.local_block_local(lblock_idx);
-        auto local_index = pattern.local_at({0,0}, lblock_view);
+    /* rows of x and y hold k elements */
+    Size k = rhs_count(x);
+    DASH_ASSERT(k == rhs_count(y));
+    auto x_intervals = mephisto::scale_intervals(col_intervals, k);
+    auto y_intervals = mephisto::scale_intervals(row_intervals, k);
 
-        auto global_index = pattern.global(local_index);
-        auto global_coords = pattern.coords(global_index);
-        //std::cout << dash::myid() << ": " << lblock_idx << " -> " << lblock_view << " : {0,0} -> " << local_index << " -> " << global_index << " -> {" << global_coords[0] << "," << global_coords[1] << "}" << std::endl;
+    // local copy of the needed parts of x
+    auto& local_x = mephisto::workspace<Data>(0, mephisto::compact_size(x_intervals));
+    mephisto::fetch_intervals(x, x_intervals, local_x.data());
+    // local result space for the touched rows of y
+    auto& local_y = mephisto::workspace<Data>(1, mephisto::compact_size(y_intervals), Data(0));
 
-        /* begin of the local block */
-        auto *lblock_begin = A.lbegin() + local_index;
+    /* the kernel is chosen by the tile width of the pattern */
+    auto kernel = ProductKernel<Data, Storage>::select(A.pattern().blocksize(1));
 
-        /* begin of the local x */
-        auto x_begin = local_x.data() + global_coords[1];
+    /* tile rows write disjoint parts of local_y, so they need no synchronization */
+    auto groups = mephisto::tile_row_groups(tiles);
+    parallel_for(groups.size(), threading, [&](long g) {
+        auto& group = groups[g];
 
         /* begin of the local y */
-        auto y_begin = local_y.data() + global_coords[0];
+        auto y_begin = local_y.data() + mephisto::compact_index(row_intervals, group.row) * k;
 
-        auto M = lblock_view.extent(0);
-        auto N = lblock_view.extent(1);
-        product(y_begin, lblock_begin, x_begin, M, N);
-    }
+        for (Size t = group.first_tile; t < group.first_tile + group.num_tiles; ++t) {
+            auto& tile = tiles[t];
+
+            /* begin of the local block */
+            auto *lblock_begin = A.lbegin() + tile.offset;
+
+            /* begin of the local x */
+            auto x_begin = local_x.data() + mephisto::compact_index(col_intervals, tile.col) * k;
+
+            if (k == 1) {
+                kernel(y_begin, lblock_begin, x_begin, tile.rows, tile.cols);
+            } else {
+                mephisto::gemv_multi(y_begin, lblock_begin, x_begin, tile.rows, tile.cols, k);
+            }
+        }
+    });
 
     /* reduce local result vectors into global y vector */
     if (A.size() <= 1024) {
@@ -153,36 +379,411 @@ void product_tile_pattern(const dash::Matrix<Data,2>& A,
         print_vector(local_y);
     }
 
-    auto& team = y.team();
-    auto team_size = team.size();
-    team.barrier();
+    if (grid) {
+        /* x only came from the process column, reduce y within the process row */
+        mephisto::reduce_scatter(local_y.data(), y_intervals, y, row_team, reduction.row_buffers);
+    } else {
+        /* every unit receives the sums of the segment of y it owns */
+        mephisto::reduce_scatter(reduction.plan, local_y.data(), y_intervals, y);
+    }
+}
+
+/**
+ * Compute y = A^T * x without forming the transpose.
+ *
+ * x has one element per row and y one element per column of A. The roles
+ * of the vectors are swapped: the parts of x are fetched for the rows of
+ * the local tiles and the partial results are kept for their columns. The
+ * local tiles are walked one tile column at a time, so every thread writes
+ * a disjoint part of the local result, and every tile is still read row
+ * by row. The partial results of all units are reduced together, as the
+ * units of a process column do not form a team.
+ */
+template<typename Data>
+void product_tile_pattern_transposed(const dash::Matrix<Data,2>&   A,
+                                     const dash::Array<Data>&      x,
+                                     dash::Array<Data>&            y,
+                                     Reduction<dash::Array<Data>>& reduction,
+                                     const ThreadConfig&           threading = ThreadConfig())
+{
+    static_assert(is_tile_pattern<typename dash::Matrix<Data,2>::pattern_type>::value,
+                  "This works only for TilePattern.");
+    DASH_ASSERT(x.size() == A.extent(0));
+    DASH_ASSERT(y.size() == A.extent(1));
+
+    using Size = decltype(A.size());
+
+    auto tiles = mephisto::tiles_by_column(mephisto::local_tiles<Size>(A));
+    /* x is read along the rows, y is written along the columns */
+    auto x_intervals = mephisto::row_intervals(tiles);
+    auto y_intervals = mephisto::column_intervals(tiles);
 
-    dash::NArray<Data,2> result_matrix(
-        dash::SizeSpec<2>(
-            y.size(),
-            team_size),
-       dash::DistributionSpec<2>{},
-        team);
-    auto& result_pattern = result_matrix.pattern();
+    auto& local_x = mephisto::workspace<Data>(0, mephisto::compact_size(x_intervals));
+    mephisto::fetch_intervals(x, x_intervals, local_x.data());
+    auto& local_y = mephisto::workspace<Data>(1, mephisto::compact_size(y_intervals), Data(0));
+
+    /* tile columns write disjoint parts of local_y */
+    auto groups = mephisto::tile_column_groups(tiles);
+    parallel_for(groups.size(), threading, [&](long g) {
+        auto& group = groups[g];
+        auto y_begin = local_y.data() + mephisto::compact_index(y_intervals, group.col);
+
+        for (Size t = group.first_tile; t < group.first_tile + group.num_tiles; ++t) {
+            auto& tile = tiles[t];
+            auto x_begin = local_x.data() + mephisto::compact_index(x_intervals, tile.row);
+            product_t(y_begin, A.lbegin() + tile.offset, x_begin, tile.rows, tile.cols);
+        }
+    });
 
-    auto myid = team.myid();
-    for (decltype(local_y.size()) i = 0; i < local_y.size(); ++i) {
-        result_matrix[i][myid] = local_y[i];
+    if (A.size() <= 1024) {
+        std::cout << dash::myid() << ": local Vector y size: " << local_y.size() << std::endl;
+        print_vector(local_y);
     }
-    team.barrier();
 
-    for (auto r = 0; r < y.size(); ++r) {
-        const auto& coord = result_pattern.local({r,0});
-        if (coord.unit != myid)
-            continue;
+    mephisto::reduce_scatter(reduction.plan, local_y.data(), y_intervals, y);
+}
+
+/**
+ * Compute y = A * x for a sparse matrix with CSR tiles.
+ *
+ * Works like product_tile_pattern with the flat reduction, but tiles
+ * without nonzeros are skipped, so their parts of x are not fetched and
+ * they add no partial sums. All units still take part in the reduction
+ * into y, see ReduceScatterPlan.
+ */
+template<typename Data>
+void product_sparse_tile_pattern(const mephisto::SparseTileMatrix<Data>& A,
+                                 const dash::Array<Data>&             x,
+                                 dash::Array<Data>&                   y,
+                                 Reduction<dash::Array<Data>>&        reduction,
+                                 const ThreadConfig&                  threading = ThreadConfig())
+{
+    using Size = typename mephisto::SparseTileMatrix<Data>::size_type;
+
+    std::vector<mephisto::TileInfo<Size>> tiles;
+    for (auto& tile : A.tiles()) {
+        if (A.tile(tile.offset).nnz() > 0)
+            tiles.push_back(tile);
+    }
+    auto col_intervals = mephisto::column_intervals(tiles);
+    auto row_intervals = mephisto::row_intervals(tiles);
+
+    auto& local_x = mephisto::workspace<Data>(0, mephisto::compact_size(col_intervals));
+    mephisto::fetch_intervals(x, col_intervals, local_x.data());
+    auto& local_y = mephisto::workspace<Data>(1, mephisto::compact_size(row_intervals), Data(0));
+
+    auto groups = mephisto::tile_row_groups(tiles);
+    parallel_for(groups.size(), threading, [&](long g) {
+        auto& group = groups[g];
+        auto y_begin = local_y.data() + mephisto::compact_index(row_intervals, group.row);
+
+        for (Size t = group.first_tile; t < group.first_tile + group.num_tiles; ++t) {
+            auto& tile = A.tile(tiles[t].offset);
+            auto x_begin = local_x.data() + mephisto::compact_index(col_intervals, tile.col);
+            mephisto::spmv(y_begin, tile, x_begin);
+        }
+    });
+
+    mephisto::reduce_scatter(reduction.plan, local_y.data(), row_intervals, y);
+}
+
+/**
+ * Time y = A * x for a sparse rows x cols matrix with the tile
+ * decomposition of the dense benchmark. The matrix is the tridiagonal
+ * second difference operator, only its nonzeros are stored.
+ */
+void benchmark_sparse(size_t rows, size_t cols, size_t tile_size,
+                      const dash::TeamSpec<2>& teamspec, const ThreadConfig& threading,
+                      mephisto::BenchReport& report)
+{
+    dash::TilePattern<2> pattern(dash::SizeSpec<2>(rows, cols),
+                                 dash::DistributionSpec<2>(
+                                   dash::TILE(tile_size),
+                                   dash::TILE(tile_size)),
+                                 teamspec,
+                                 dash::Team::All());
+
+    mephisto::SparseTileMatrix<double> matrix(pattern, [](size_t r, size_t begin, size_t end, auto emit) {
+        /* columns r - 1, r and r + 1 that fall into [begin, end) */
+        for (size_t c = std::max(begin, r > 0 ? r - 1 : 0); c < std::min(end, r + 2); ++c) {
+            emit(c, r == c ? 2.0 : -1.0);
+        }
+    });
+
+    dash::Array<double> vector_x(cols);
+    dash::Array<double> vector_y(rows);
+    std::fill(vector_x.lbegin(), vector_x.lend(), (double)dash::myid());
+
+    size_t local_nnz = matrix.local_nnz();
+    size_t nnz = 0;
+    dart_allreduce(&local_nnz, &nnz, 1,
+                   dash::dart_datatype<size_t>::value,
+                   DART_OP_SUM,
+                   dash::Team::All().dart_id());
+
+    Reduction<dash::Array<double>> reduction(vector_y);
+    auto stats = mephisto::time_collective(report.config(), dash::Team::All(), [&] {
+        product_sparse_tile_pattern(matrix, vector_x, vector_y, reduction, threading);
+    });
+
+    /* every nonzero is read with its column index */
+    mephisto::BenchResult result = mephisto::dense_result("sparse", rows, cols, 1, "double", stats);
+    result.flops = 2.0 * nnz;
+    result.bytes = nnz * (sizeof(double) + sizeof(size_t)) + (rows + cols) * sizeof(double);
+    result.error = mephisto::reference_error(matrix, vector_x, vector_y);
+    result.tolerance = mephisto::product_tolerance<double>(cols);
+    report.add(result);
+}
+
+/**
+ * Compute y = A * x for a symmetric matrix that only stores the tiles on
+ * and above the diagonal.
+ *
+ * x and y are fetched and reduced for the rows and the columns of the
+ * stored tiles. Every off-diagonal tile is read once and contributes to y
+ * at its rows and, as its transpose, at its columns. Tile rows share
+ * columns, so every thread sums up into a local result of its own, and
+ * the local results are added up after the tile loop.
+ */
+template<typename Data>
+void product_symmetric_tile_pattern(const mephisto::SymmetricTileMatrix<Data>& A,
+                                    const dash::Array<Data>&                x,
+                                    dash::Array<Data>&                      y,
+                                    Reduction<dash::Array<Data>>&           reduction,
+                                    const ThreadConfig&                     threading = ThreadConfig())
+{
+    using Size = typename mephisto::SymmetricTileMatrix<Data>::size_type;
+
+    auto& tiles = A.tiles();
+    auto intervals = mephisto::index_intervals(tiles);
+    Size nelem = mephisto::compact_size(intervals);
+
+    auto& local_x = mephisto::workspace<Data>(0, nelem);
+    mephisto::fetch_intervals(x, intervals, local_x.data());
+    std::vector<mephisto::host_vector<Data>*> thread_y;
+    for (int thread = 0; thread < threading.threads; ++thread) {
+        thread_y.push_back(&mephisto::workspace<Data>(1 + thread, nelem, Data(0)));
+    }
+
+    auto kernel = select_product<Data>(A.pattern().blocksize(1));
+
+    auto groups = mephisto::tile_row_groups(tiles);
+    parallel_for(groups.size(), threading, [&](long g) {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        auto& group = groups[g];
+        auto& local_y = *thread_y[thread];
+        Size row = mephisto::compact_index(intervals, group.row);
 
-        Data sum = (Data)0;
-        for (decltype(team_size) c = 0; c < team_size; ++c) {
-            sum += result_matrix.local[coord.coords[0]][c];
+        for (Size t = group.first_tile; t < group.first_tile + group.num_tiles; ++t) {
+            auto& tile = tiles[t];
+            Size col = mephisto::compact_index(intervals, tile.col);
+            auto *lblock_begin = A.lbegin() + tile.offset;
+
+            if (tile.row == tile.col) {
+                kernel(local_y.data() + row, lblock_begin, local_x.data() + col, tile.rows, tile.cols);
+            } else {
+                mephisto::gemv_symmetric(local_y.data() + row, local_y.data() + col, lblock_begin,
+                                         local_x.data() + col, local_x.data() + row,
+                                         tile.rows, tile.cols);
+            }
         }
-        y[r] = sum;
+    });
+
+    for (size_t thread = 1; thread < thread_y.size(); ++thread) {
+        std::transform(thread_y[0]->begin(), thread_y[0]->end(), thread_y[thread]->begin(),
+                       thread_y[0]->begin(), std::plus<Data>());
     }
-    team.barrier();
+
+    mephisto::reduce_scatter(reduction.plan, thread_y[0]->data(), intervals, y);
+}
+
+/**
+ * Time y = A * x for a symmetric n x n matrix with the tile decomposition
+ * of the dense benchmark, storing only the tiles on and above the diagonal.
+ */
+void benchmark_symmetric(size_t n, size_t tile_size,
+                         const dash::TeamSpec<2>& teamspec, const ThreadConfig& threading,
+                         mephisto::BenchReport& report)
+{
+    dash::TilePattern<2> pattern(dash::SizeSpec<2>(n, n),
+                                 dash::DistributionSpec<2>(
+                                   dash::TILE(tile_size),
+                                   dash::TILE(tile_size)),
+                                 teamspec,
+                                 dash::Team::All());
+
+    mephisto::SymmetricTileMatrix<double> matrix(pattern, [](size_t r, size_t c) {
+        return 1.0 / (1.0 + (c - r));
+    });
+
+    dash::Array<double> vector_x(n);
+    dash::Array<double> vector_y(n);
+    std::fill(vector_x.lbegin(), vector_x.lend(), (double)dash::myid());
+
+    size_t local_size = matrix.local_size();
+    size_t stored = 0;
+    dart_allreduce(&local_size, &stored, 1,
+                   dash::dart_datatype<size_t>::value,
+                   DART_OP_SUM,
+                   dash::Team::All().dart_id());
+
+    Reduction<dash::Array<double>> reduction(vector_y);
+    auto stats = mephisto::time_collective(report.config(), dash::Team::All(), [&] {
+        product_symmetric_tile_pattern(matrix, vector_x, vector_y, reduction, threading);
+    });
+
+    /* the work of the full matrix, but only the stored tiles are read */
+    mephisto::BenchResult result = mephisto::dense_result("symmetric", n, n, 1, "double", stats);
+    result.bytes = stored * sizeof(double) + 2 * n * sizeof(double);
+    result.error = mephisto::reference_error(matrix, vector_x, vector_y);
+    result.tolerance = mephisto::product_tolerance<double>(n);
+    report.add(result);
+}
+
+/**
+ * Add n values to the elements of y starting at global index g with
+ * one-sided accumulates, one per owning unit. The accumulates are only
+ * complete after a flush, values must not change until then. y has to
+ * be block distributed.
+ */
+template<typename Data>
+void accumulate_async(dash::Array<Data>& y, size_t g, const Data* values, size_t n)
+{
+    auto& pattern = y.pattern();
+    while (n > 0) {
+        auto local_pos = pattern.local(g);
+        size_t len = std::min<size_t>(n, pattern.local_size(local_pos.unit) - local_pos.index);
+        dart_accumulate((y.begin() + g).dart_gptr(),
+                        values, len,
+                        dash::dart_datatype<Data>::value,
+                        DART_OP_SUM);
+        g += len;
+        values += len;
+        n -= len;
+    }
+}
+
+/**
+ * Compute y = A * x, overlapping communication with computation.
+ *
+ * The part of x of every local tile column is fetched asynchronously, in
+ * column order. The tiles of a tile column are multiplied on the threads
+ * of the configuration as soon as their part of x has arrived; while none
+ * has arrived, the unit blocks on the first pending fetch. Every finished
+ * tile row of the local result is accumulated into y right away while the
+ * remaining tiles are still being computed.
+ */
+template<typename Data>
+void product_tile_pattern_pipelined(const dash::Matrix<Data,2>& A,
+                                    const dash::Array<Data>&    x,
+                                    dash::Array<Data>&          y,
+                                    const ThreadConfig&         threading)
+{
+    static_assert(is_tile_pattern<typename dash::Matrix<Data,2>::pattern_type>::value,
+                  "This works only for TilePattern.");
+
+    using Size = decltype(A.size());
+    using Interval = mephisto::IndexInterval<Size>;
+
+    auto tiles = mephisto::local_tiles<Size>(A);
+    auto groups = mephisto::tile_row_groups(tiles);
+    auto col_intervals = mephisto::column_intervals(tiles);
+    auto row_intervals = mephisto::row_intervals(tiles);
+
+    auto& local_x = mephisto::workspace<Data>(0, mephisto::compact_size(col_intervals));
+    auto& local_y = mephisto::workspace<Data>(1, mephisto::compact_size(row_intervals), Data(0));
+
+    /* y is accumulated into, so it has to be cleared on all units first */
+    std::fill(y.lbegin(), y.lend(), (Data)0);
+    y.team().barrier();
+
+    /* the tile columns in column order and the tiles in each of them */
+    std::vector<Interval> col_blocks;
+    for (auto& tile : tiles) {
+        col_blocks.push_back(Interval{tile.col, tile.col + tile.cols,
+                                      mephisto::compact_index(col_intervals, tile.col)});
+    }
+    std::sort(col_blocks.begin(), col_blocks.end(),
+              [](const Interval& a, const Interval& b) { return a.begin < b.begin; });
+    col_blocks.erase(std::unique(col_blocks.begin(), col_blocks.end(),
+                                 [](const Interval& a, const Interval& b) { return a.begin == b.begin; }),
+                     col_blocks.end());
+
+    std::vector<std::vector<Size>> col_block_tiles(col_blocks.size());
+    std::vector<Size> tile_group(tiles.size());
+    std::vector<Size> remaining(groups.size());
+    for (Size g = 0; g < groups.size(); ++g) {
+        remaining[g] = groups[g].num_tiles;
+        for (Size t = groups[g].first_tile; t < groups[g].first_tile + groups[g].num_tiles; ++t) {
+            tile_group[t] = g;
+        }
+    }
+    for (Size t = 0; t < tiles.size(); ++t) {
+        auto block = std::lower_bound(col_blocks.begin(), col_blocks.end(), tiles[t].col,
+                                      [](const Interval& a, Size col) { return a.begin < col; });
+        col_block_tiles[block - col_blocks.begin()].push_back(t);
+    }
+
+    auto kernel = select_product<Data>(A.pattern().blocksize(1));
+
+    /* start fetching all parts of x */
+    std::vector<dash::Future<Data*>> fetches;
+    for (auto& block : col_blocks) {
+        fetches.push_back(dash::copy_async(x.begin() + block.begin,
+                                           x.begin() + block.end,
+                                           local_x.data() + block.offset));
+    }
+
+    /* multiply the tiles of every tile column whose part of x has arrived */
+    std::vector<bool> done(col_blocks.size(), false);
+    Size pending = col_blocks.size();
+    while (pending > 0) {
+        std::vector<Size> ready;
+        for (Size b = 0; b < col_blocks.size(); ++b) {
+            if (!done[b] && fetches[b].test())
+                ready.push_back(b);
+        }
+        /* nothing has arrived, wait for the first pending part */
+        if (ready.empty()) {
+            Size b = std::find(done.begin(), done.end(), false) - done.begin();
+            fetches[b].wait();
+            ready.push_back(b);
+        }
+
+        for (auto b : ready) {
+            done[b] = true;
+            --pending;
+
+            /* the tiles of a tile column belong to different tile rows */
+            auto& block_tiles = col_block_tiles[b];
+            parallel_for(block_tiles.size(), threading, [&](long i) {
+                auto& tile = tiles[block_tiles[i]];
+                auto y_begin = local_y.data() + mephisto::compact_index(row_intervals, tile.row);
+                auto x_begin = local_x.data() + col_blocks[b].offset;
+                kernel(y_begin, A.lbegin() + tile.offset, x_begin, tile.rows, tile.cols);
+            });
+
+            /* send off the tile rows that are complete now */
+            for (auto t : block_tiles) {
+                auto& group = groups[tile_group[t]];
+                if (--remaining[tile_group[t]] == 0) {
+                    auto y_begin = local_y.data() + mephisto::compact_index(row_intervals, group.row);
+                    accumulate_async(y, group.row, y_begin, group.rows);
+                }
+            }
+        }
+    }
+
+    if (A.size() <= 1024) {
+        std::cout << dash::myid() << ": local Vector y size: " << local_y.size() << std::endl;
+        print_vector(local_y);
+    }
+
+    dart_flush_all(y.begin().dart_gptr());
+    y.team().barrier();
 }
 
 int main(int argc, char* argv[])
@@ -192,9 +793,6 @@ int main(int argc, char* argv[])
     dart_unit_t myid = dash::myid();
     size_t num_units = dash::Team::All().size();
 
-    dash::TeamSpec<2> teamspec_2d(num_units, 1);
-    teamspec_2d.balance_extents();
-
     size_t size_factor = 4;
     if (argc > 1) {
         std::istringstream in(argv[1]);
@@ -205,10 +803,191 @@ int main(int argc, char* argv[])
         std::istringstream in(argv[2]);
         in >> tile_size;
     }
+    /* number of process rows, 0 chooses a balanced grid */
+    size_t process_rows = 0;
+    if (argc > 3) {
+        std::istringstream in(argv[3]);
+        in >> process_rows;
+    }
+    /* reduce y within process rows (grid), over all units (flat),
+     * overlap the communication with the computation (pipelined),
+     * time the grid product for a growing number of threads (scaling),
+     * multiply with the transpose of the matrix (transposed), multiply
+     * a sparse matrix stored in CSR tiles (sparse), or a symmetric matrix
+     * of which only the upper triangular tiles are stored (symmetric) */
+    std::string mode = "grid";
+    if (argc > 4) {
+        mode = argv[4];
+    }
+    /* threads per unit for the tile loop, 0 uses all available */
+    ThreadConfig threading;
+    if (argc > 5) {
+        std::istringstream in(argv[5]);
+        in >> threading.threads;
+    }
+    if (threading.threads <= 0) {
+#ifdef _OPENMP
+        threading.threads = omp_get_max_threads();
+#else
+        threading.threads = 1;
+#endif
+    }
+    /* binding of the threads: none, close or spread */
+    if (argc > 6) {
+        threading.affinity = argv[6];
+    }
+    /* number of right-hand sides multiplied at once */
+    size_t rhs = 1;
+    if (argc > 7) {
+        std::istringstream in(argv[7]);
+        in >> rhs;
+    }
+    /* storage type of the matrix: double, float or bf16 */
+    std::string storage = "double";
+    if (argc > 8) {
+        storage = argv[8];
+    }
+    /* matrix to load instead of the generated one, a Matrix Market file
+     * (.mtx) or a file in the tiled format whose tile size is used */
+    std::string matrix_file;
+    if (argc > 9) {
+        matrix_file = argv[9];
+    }
+    /* file the matrix is written to in the tiled format */
+    std::string tiled_file;
+    if (argc > 10) {
+        tiled_file = argv[10];
+    }
+    /* allocation of host buffers, pages[:alignment] with pages default,
+     * thp or huge */
+    if (argc > 11) {
+        try {
+            mephisto::default_allocation_policy() = mephisto::parse_allocation_policy(argv[11]);
+        } catch (std::runtime_error& e) {
+            if (0 == myid) {
+                std::cerr << e.what() << std::endl;
+            }
+            dash::finalize();
+            return EXIT_FAILURE;
+        }
+    }
+    /* reporting of the timings, format[:warmup[:repetitions[:file]]] with
+     * format text, csv or json, followed by +stream to compare the results
+     * with the STREAM triad bandwidth */
+    mephisto::BenchConfig bench;
+    if (argc > 12) {
+        try {
+            bench = mephisto::parse_bench_config(argv[12]);
+        } catch (std::runtime_error& e) {
+            if (0 == myid) {
+                std::cerr << e.what() << std::endl;
+            }
+            dash::finalize();
+            return EXIT_FAILURE;
+        }
+    }
+    if (storage != "double" && storage != "float" && storage != "bf16") {
+        if (0 == myid) {
+            std::cerr << "unknown storage type " << storage << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
+    if (mode != "grid" && mode != "flat" && mode != "pipelined" && mode != "scaling"
+     && mode != "transposed" && mode != "sparse" && mode != "symmetric") {
+        if (0 == myid) {
+            std::cerr << "unknown mode " << mode << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
+    if (storage != "double" && (rhs > 1 || (mode != "grid" && mode != "flat"))) {
+        if (0 == myid) {
+            std::cerr << "storage type " << storage
+                      << " is only supported in grid and flat mode with a single right-hand side" << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
+    if (rhs > 1 && mode != "grid" && mode != "flat") {
+        if (0 == myid) {
+            std::cerr << "mode " << mode << " multiplies a single right-hand side" << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
+    if ((mode == "sparse" || mode == "symmetric") && (!matrix_file.empty() || !tiled_file.empty())) {
+        if (0 == myid) {
+            std::cerr << "mode " << mode << " does not read or write matrix files" << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
+    if (process_rows > 0 && num_units % process_rows != 0) {
+        if (0 == myid) {
+            std::cerr << "the number of units " << num_units
+                      << " is not a multiple of the process rows " << process_rows << std::endl;
+        }
+        dash::finalize();
+        return EXIT_FAILURE;
+    }
+    bool matrix_market = matrix_file.size() > 4
+                      && matrix_file.compare(matrix_file.size() - 4, 4, ".mtx") == 0;
+
+    dash::TeamSpec<2> teamspec_2d(num_units, 1);
+    if (process_rows > 0) {
+        teamspec_2d = dash::TeamSpec<2>(process_rows, num_units / process_rows);
+    } else {
+        teamspec_2d.balance_extents();
+    }
+
+    /* units of a process row are consecutive, so splitting yields the row teams */
+    bool split_rows = mode == "grid" || mode == "scaling";
+    dash::Team& row_team = split_rows
+                         ? dash::Team::All().split(teamspec_2d.num_units(0))
+                         : dash::Team::All();
+    DASH_ASSERT(!split_rows || row_team.size() == teamspec_2d.num_units(1));
+
     size_t rows = tile_size * teamspec_2d.num_units(0) * size_factor;
     size_t cols = tile_size * teamspec_2d.num_units(1) * size_factor;
+    if (matrix_market) {
+        auto info = mephisto::read_matrix_market_info(matrix_file);
+        rows = info.rows;
+        cols = info.cols;
+    } else if (!matrix_file.empty()) {
+        auto header = mephisto::read_tiled_header(matrix_file);
+        if (header.tile_rows != header.tile_cols) {
+            if (0 == myid) {
+                std::cerr << matrix_file << " has tiles of " << header.tile_rows << " x " << header.tile_cols
+                          << " elements, only square tiles are supported" << std::endl;
+            }
+            dash::finalize();
+            return EXIT_FAILURE;
+        }
+        rows      = header.rows;
+        cols      = header.cols;
+        tile_size = header.tile_rows;
+    }
     size_t matrix_size = rows * cols;
 
+    /* the STREAM ceiling is only measured on request, it takes a while */
+    double ceiling = bench.stream ? mephisto::stream_ceiling(dash::Team::All(), threading.threads) : 0.0;
+    mephisto::BenchReport report("dash-mxv", bench, ceiling);
+
+    if (mode == "sparse" || mode == "symmetric") {
+        /* the dense matrix is never allocated */
+        if (mode == "sparse") {
+            benchmark_sparse(rows, cols, tile_size, teamspec_2d, threading, report);
+        } else {
+            benchmark_symmetric(std::max(rows, cols), tile_size, teamspec_2d, threading, report);
+        }
+        if (0 == myid) {
+            report.write();
+        }
+        dash::finalize();
+        return report.passed() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     if (matrix_size <= 1024 && 0 == myid) {
         std::cout << "Matrix size: " << rows
                   << " x " << cols
@@ -229,15 +1008,34 @@ int main(int argc, char* argv[])
     DASH_ASSERT(rows == matrix.extent(0));
     DASH_ASSERT(cols == matrix.extent(1));
 
-    dash::Array<double> vector_x(cols);
-    dash::Array<double> vector_y(rows);
+    /* A^T * x maps vectors of length rows to vectors of length cols */
+    bool transposed = mode == "transposed";
+    dash::Array<double> vector_x(transposed ? rows : cols);
+    dash::Array<double> vector_y(transposed ? cols : rows);
 
     dash::Team::All().barrier();
 
-    std::fill(matrix.lbegin(), matrix.lend(), (double)myid);
+    if (matrix_market) {
+        /* every unit parses the file and keeps its own tiles */
+        mephisto::read_matrix_market(matrix, matrix_file);
+    } else if (!matrix_file.empty()) {
+        /* every unit copies its own tiles from the mapped file */
+        mephisto::read_tiled(matrix, matrix_file);
+    } else if (storage == "double") {
+        std::fill(matrix.lbegin(), matrix.lend(), (double)myid);
+    } else {
+        /* values that are not exact in the narrow types */
+        for (size_t i = 0; i < matrix.local_size(); ++i) {
+            matrix.lbegin()[i] = myid + (i % 7) / 7.0;
+        }
+    }
     std::fill(vector_x.lbegin(), vector_x.lend(), (double)myid);
     std::fill(vector_y.lbegin(), vector_y.lend(), 0.0);
 
+    if (!tiled_file.empty()) {
+        mephisto::write_tiled(matrix, tiled_file);
+    }
+
     dash::Team::All().barrier();
     if (matrix_size <= 1024 && 0 == myid) {
         print_matrix(matrix);
@@ -246,17 +1044,77 @@ int main(int argc, char* argv[])
         print_vector(vector_x);
     }
 
-    auto const tpStart(std::chrono::high_resolution_clock::now());
-    dash::Team::All().barrier();
+    /* the plan of the reduction into y is built once for all products */
+    Reduction<dash::Array<double>> reduction(vector_y);
 
-    product_tile_pattern(matrix, vector_x, vector_y);
+    if (rhs > 1) {
+        /* blocks of rhs vectors, every unit owns whole rows of them */
+        dash::Matrix<double, 2> block_x(
+                             dash::SizeSpec<2>(cols, rhs),
+                             dash::DistributionSpec<2>(
+                               dash::TILE(tile_size),
+                               dash::TILE(rhs)),
+                             dash::Team::All(),
+                             dash::TeamSpec<2>(num_units, 1));
+        dash::Matrix<double, 2> block_y(
+                             dash::SizeSpec<2>(rows, rhs),
+                             dash::DistributionSpec<2>(
+                               dash::TILE(tile_size),
+                               dash::TILE(rhs)),
+                             dash::Team::All(),
+                             dash::TeamSpec<2>(num_units, 1));
 
-    dash::Team::All().barrier();
-    auto const tpEnd(std::chrono::high_resolution_clock::now());
+        std::fill(block_x.lbegin(), block_x.lend(), (double)myid);
+        std::fill(block_y.lbegin(), block_y.lend(), 0.0);
 
-    auto const durElapsed(tpEnd - tpStart);
-    if (0 == myid) {
-        std::cout << rows << " " << cols << " " << std::chrono::duration_cast<std::chrono::microseconds>(durElapsed).count() << std::endl;
+        Reduction<dash::Matrix<double, 2>> block_reduction(block_y);
+        auto stats = mephisto::time_collective(bench, dash::Team::All(), [&] {
+            product_tile_pattern(matrix, block_x, block_y, block_reduction, row_team, threading);
+        });
+
+        mephisto::BenchResult result = mephisto::dense_result(mode, rows, cols, rhs, storage, stats);
+        result.error = mephisto::reference_error(matrix, block_x, block_y, rhs);
+        result.tolerance = mephisto::product_tolerance<double>(cols);
+        report.add(result);
+    } else if (storage == "float") {
+        mephisto::benchmark_storage<float>(report, mode, storage, matrix, vector_x, vector_y,
+            [&](auto& A) { product_tile_pattern(A, vector_x, vector_y, reduction, row_team, threading); });
+    } else if (storage == "bf16") {
+        mephisto::benchmark_storage<mephisto::bfloat16>(report, mode, storage, matrix, vector_x, vector_y,
+            [&](auto& A) { product_tile_pattern(A, vector_x, vector_y, reduction, row_team, threading); });
+    } else if (mode == "scaling") {
+        /* 1, 2, 4, ... threads up to the configured number */
+        for (int threads = 1; ; threads = std::min(2 * threads, threading.threads)) {
+            ThreadConfig config = threading;
+            config.threads = threads;
+
+            auto stats = mephisto::time_collective(bench, dash::Team::All(), [&] {
+                product_tile_pattern(matrix, vector_x, vector_y, reduction, row_team, config);
+            });
+
+            mephisto::BenchResult result = mephisto::dense_result("threads(" + std::to_string(threads) + ")",
+                                                        rows, cols, 1, storage, stats);
+            result.error = mephisto::reference_error(matrix, vector_x, vector_y);
+            result.tolerance = mephisto::product_tolerance<double>(cols);
+            report.add(result);
+            if (threads == threading.threads)
+                break;
+        }
+    } else {
+        auto stats = mephisto::time_collective(bench, dash::Team::All(), [&] {
+            if (mode == "pipelined") {
+                product_tile_pattern_pipelined(matrix, vector_x, vector_y, threading);
+            } else if (transposed) {
+                product_tile_pattern_transposed(matrix, vector_x, vector_y, reduction, threading);
+            } else {
+                product_tile_pattern(matrix, vector_x, vector_y, reduction, row_team, threading);
+            }
+        });
+
+        mephisto::BenchResult result = mephisto::dense_result(mode, rows, cols, 1, storage, stats);
+        result.error = mephisto::reference_error(matrix, vector_x, vector_y, 1, transposed);
+        result.tolerance = mephisto::product_tolerance<double>(transposed ? rows : cols);
+        report.add(result);
     }
 
     if (matrix_size <= 1024 && 0 == myid) {
@@ -264,9 +1122,13 @@ int main(int argc, char* argv[])
         print_vector(vector_y);
     }
 
+    if (0 == myid) {
+        report.write();
+    }
+
     dash::Team::All().barrier();
 
     dash::finalize();
 
-    return 0;
+    return report.passed() ? EXIT_SUCCESS : EXIT_FAILURE;
 }